@@ -0,0 +1,25 @@
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stddef.h>
+
+/** Default size of a slab */
+#define SLAB_SIZE 65536
+
+/** A block of memory of the arena */
+typedef struct slab {
+  struct slab *next;
+  size_t used;
+  size_t size;
+  max_align_t data[];
+} slab_t;
+
+/** Bump-pointer allocator where all the memory is freed at once */
+typedef struct arena {
+  slab_t *slab;   /**< The current slab, head of the slabs' list */
+} arena_t;
+
+void *arena_alloc(arena_t *arena, size_t size);
+void arena_free(arena_t *arena);
+
+#endif /* _ARENA_H */
@@ -5,5 +5,6 @@
 
 int action(KEY_ARGS);
 int action_stop(KEY_ARGS);
+int action_inline(KEY_ARGS);
 
 #endif /* _LIA_ACTION_H */
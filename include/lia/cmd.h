@@ -20,15 +20,22 @@
 #define OPREG(x)  { .reg = x }
 #define OPIMM(x)  { .imm = x }
 #define OPPROC(x) { .procedure = x }
-#define OPNULL    { .reg = {0} }
+#define OPNULL    { .reg = 0 }
 
+/** The value at the accumulator isn't known at compile-time */
+#define ACC_UNKNOWN (-1L)
 
-int reg_compile(FILE *output, char *reg, int get);
-void imm_compile(FILE *output, uint8_t imm);
-token_t *str_compile(char *filename, FILE *output, token_t *tk);
-int isreg(token_t *tk);
 
-cmd_t *lia_cmd_new(cmd_t *tree, char *name, cmd_arg_t *args, token_t *body);
-int lia_cmd_compile(proc_t *proctree, char *filename, FILE *output, cmd_t *cmd, operand_t *ops);
+int reg_compile(out_t *output, reg_t reg, int get);
+size_t delta_length(long int delta);
+void delta_compile(out_t *output, long int delta);
+void imm_compile(out_t *output, uint8_t imm);
+void imm_compile_state(out_t *output, const state_t *state, uint8_t imm);
+token_t *str_compile(char *filename, out_t *output, token_t *tk, int cache,
+  long int acc);
+
+cmd_t *lia_cmd_new(map_t *cmds, char *name, cmd_arg_t *args, token_t *body);
+int lia_cmd_compile(map_t *procs, char *filename, out_t *output, cmd_t *cmd,
+  operand_t *ops, const state_t *state);
 
 #endif /* _LIA_CMD_H */
@@ -1,18 +1,32 @@
 #ifndef _LIA_ERROR_H
 #define _LIA_ERROR_H
 
+#include <stdbool.h>
+
+/** Suppresses the messages, to compile a code only to test it */
+extern bool lia_silent;
+
 #ifdef __linux__
 
-#define lia_error(file, line, col, fmt, ...)    \
-  fprintf(stderr, "\x1b[37;1m%s"                     \
-    ": \x1b[31;1merror\x1b[0m at %d:%d> " fmt "\n",   \
-    file, line, col, __VA_ARGS__)
+#define lia_error(file, line, col, fmt, ...)                          \
+  (lia_silent ? 0 : fprintf(stderr, "\x1b[37;1m%s"                    \
+    ": \x1b[31;1merror\x1b[0m at %d:%d> " fmt "\n",                   \
+    file, line, col, __VA_ARGS__))
+
+#define lia_warning(file, line, col, fmt, ...)                        \
+  (lia_silent ? 0 : fprintf(stderr, "\x1b[37;1m%s"                    \
+    ": \x1b[33;1mwarning\x1b[0m at %d:%d> " fmt "\n",                 \
+    file, line, col, __VA_ARGS__))
 
 #else
 
-#define lia_error(file, line, col, fmt, ...)   \
-  fprintf(stderr, "%s: error at %d:%d> " fmt "\n",  \
-    file, line, col, __VA_ARGS__)
+#define lia_error(file, line, col, fmt, ...)                          \
+  (lia_silent ? 0 : fprintf(stderr, "%s: error at %d:%d> " fmt "\n",  \
+    file, line, col, __VA_ARGS__))
+
+#define lia_warning(file, line, col, fmt, ...)                        \
+  (lia_silent ? 0 : fprintf(stderr, "%s: warning at %d:%d> " fmt "\n", \
+    file, line, col, __VA_ARGS__))
 
 #endif
 
@@ -1,8 +1,9 @@
 #ifndef _LIA_FREE_H
 #define _LIA_FREE_H
 
-void tkfree(token_t *tk);
-void inst_free(inst_t *list);
+void inst_free(instlist_t *list);
+void macro_free(void *macro);
+void cmd_free(void *cmd);
 void lia_free(lia_t *lia);
 
 #endif /* _LIA_FREE_H */
@@ -18,6 +18,9 @@ int chresc(int c);
 token_type_t name2tktype(char *name);
 const char *tktype2name(token_type_t type);
 
-token_t *lia_lexer(char *filename, FILE *input);
+void tktext(lia_t *lia, token_t *tk, const char *text, size_t length);
+token_t *tknew(lia_t *lia);
+token_t *tkcopy(lia_t *lia, const token_t *src);
+token_t *lia_lexer(char *filename, FILE *input, lia_t *lia);
 
 #endif /* _LIA_LEXER_H */
@@ -8,9 +8,13 @@
 #include "lia/error.h"
 #include "lia/lexer.h"
 #include "lia/cmd.h"
+#include "lia/state.h"
 #include "lia/parser.h"
+#include "lia/memo.h"
 #include "lia/procedure.h"
 #include "lia/compiler.h"
+#include "lia/optimize.h"
+#include "lia/peephole.h"
 #include "lia/target.h"
 #include "lia/action.h"
 
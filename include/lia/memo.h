@@ -0,0 +1,27 @@
+/**
+ * @file    memo.h
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Header file declaring the cache of the macro's expansions
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ */
+#ifndef _LIA_MEMO_H
+#define _LIA_MEMO_H
+
+#include "lia/types.h"
+
+/** Initial number of buckets of the cache */
+#define MEMO_SIZE 64
+
+unsigned long int memo_hash(macro_var_t *variant, token_t **args, size_t argc);
+macro_memo_t *memo_find(memo_t *memo, unsigned long int hash,
+  unsigned long int generation, macro_var_t *variant, token_t **args,
+  size_t argc);
+macro_memo_t *memo_new(unsigned long int hash, unsigned long int generation,
+  macro_var_t *variant, token_t **args, size_t argc);
+void memo_insert(memo_t *memo, macro_memo_t *entry);
+void memo_free(memo_t *memo);
+
+#endif /* _LIA_MEMO_H */
@@ -0,0 +1,25 @@
+/**
+ * @file    optimize.h
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Header file declaring the optimizer's passes
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ */
+#ifndef _LIA_OPTIMIZE_H
+#define _LIA_OPTIMIZE_H
+
+#include "lia/types.h"
+
+int opt_callees(lia_t *lia, inst_t *inst, token_t **callees);
+opt_proc_t **opt_procs(lia_t *lia, map_t *map, size_t *count);
+int opt_deadprocs(lia_t *lia);
+void opt_procorder(lia_t *lia);
+void opt_declare(lia_t *lia, int first);
+void opt_effects(lia_t *lia, inst_t *inst, opt_effects_t *eff);
+unsigned int opt_deadstores(lia_t *lia);
+int opt_unreachable(lia_t *lia);
+unsigned int opt_inline(lia_t *lia);
+
+#endif /* _LIA_OPTIMIZE_H */
@@ -15,14 +15,48 @@
 /** The name of the special expression macro */
 #define MACRO_EXPR "expr"
 #define EXPR_LVALUE "rc"
+#define EXPR_LVALUE_REG REG_RC
 
+/** Maximum number of tokens at the arguments of a macro */
+#define MACRO_ARGMAX (TKMAX - 1)
 
+/** Default limits of the macro's expansions */
+#define MACRO_MAXDEPTH 1024
+#define MACRO_MAXGROWTH 16777216
+
+/** Maximum nesting of the `expr' expansions, which are parsed recursively */
+#define MACRO_MAXNEST 256
+
+/** Initial number of frames at the work stack of the expansions */
+#define MACRO_STACKSIZE 16
+
+/** Frame of the work stack of the macro's expansions */
+typedef struct macro_frame {
+  token_t *first;    /**< The first token of the call */
+  token_t *tk;       /**< The macro's name, or the token before '(' */
+  token_t *cursor;   /**< The next token of the arguments, or NULL */
+  bool resumed;      /**< If the cursor is the result of a expansion */
+  bool expr;
+  macro_t *macro;
+  macro_node_t *node;
+  size_t argc;
+  token_t *args[MACRO_ARGMAX];
+} macro_frame_t;
+
+/** Character representing a token's type at the signature of a variant */
+#define TKSIG(type) ( 'A' + (type) )
+
+
+metakeyword_t name2metakey(const char *name, size_t length);
 metakeyword_t ismetakey(token_t *tk);
 token_t *metanext(token_t *tk);
 token_t *lasttype(token_t *tk, token_type_t type);
 mtk_t *macro_tkseq_add(mtk_t *list, token_type_t type, char *name);
 void chrrep(char *dest, char *src, int placeholder, const char *new);
-void macro_seq_print(void *tree_node);
+void macro_seq_print(void *variant);
+void macro_candidates(macro_node_t *node);
+void macro_trie_add(lia_t *lia, macro_t *macro, macro_var_t *variant);
+void macro_template(lia_t *lia, macro_var_t *variant);
 token_t *macro_expand(token_t *tk, imp_t *file, lia_t *lia);
 token_t *meta_new(KEY_ARGS);
 token_t *meta_import(KEY_ARGS);
@@ -31,6 +65,7 @@ token_t *meta_require(KEY_ARGS);
 token_t *meta_if(KEY_ARGS);
 token_t *meta_action(KEY_ARGS);
 
+keyword_t name2key(const char *name, size_t length);
 keyword_t iskey(token_t *tk);
 token_t *cmd_verify(KEY_ARGS);
 token_t *key_func(KEY_ARGS);
@@ -49,9 +84,10 @@ token_t *key_say(KEY_ARGS);
 token_t *key_ases(KEY_ARGS);
 
 int tkseq(token_t *tk, unsigned int number, ...);
-inst_t *inst_add(inst_t *list, inst_type_t type);
-token_t *macro_set(macro_t *tree, char *name, token_type_t type);
-void macrostr_set(macro_t *tree, char *name, const char *value);
+inst_t *inst_add(instlist_t *list, inst_type_t type);
+inst_t *inst_next(instlist_t *list, inst_t *inst);
+token_t *macro_set(lia_t *lia, char *name, token_type_t type);
+void macrostr_set(lia_t *lia, char *name, const char *value);
 int lia_parser(lia_t *lia, imp_t *file);
 token_t *inst_parser(lia_t *lia, imp_t *file, token_t *this);
 
@@ -0,0 +1,48 @@
+/**
+ * @file    peephole.h
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Header file declaring the peephole optimizer of the Ases code
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ */
+#ifndef _LIA_PEEPHOLE_H
+#define _LIA_PEEPHOLE_H
+
+#include <stddef.h>
+
+/** Mask enabling all the peephole's rules */
+#define PEEP_ALL (~0UL)
+
+/** Bit of a rule at the mask */
+#define PEEP_BIT(x) (1UL << (x))
+
+/** Index of the rules at peep_rules */
+enum {
+  PEEP_CANCEL,
+  PEEP_RELOAD,
+  PEEP_RESTORE,
+  PEEP_DEADACC,
+  PEEP_BLANK,    /**< Applied while reading the code */
+  PEEP_COUNT
+};
+
+/** A rewrite rule of the peephole optimizer */
+typedef struct peep_rule {
+  const char *name;
+  const char *description;
+
+  /**
+   * Rewrites the end of the code, returning its new length. The code
+   * before the barrier can't be changed.
+   */
+  size_t (*apply)(char *code, size_t length, size_t barrier);
+} peep_rule_t;
+
+extern const peep_rule_t peep_rules[];
+
+int peep_find(const char *name);
+size_t peep_optimize(char *code, size_t length, unsigned long int rules);
+
+#endif /* _LIA_PEEPHOLE_H */
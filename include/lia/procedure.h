@@ -25,9 +25,20 @@
  */
 #define PROC_CALLSIZE ( sizeof (PROC_CALL1) + sizeof (PROC_CALL2) - 3 )
 
+/**
+ * The compact encoding sets dp to the index with an immediate instead of
+ * moving it one cell at a time. Large indexes are built doubling the
+ * accumulator with ra, so ra is saved at the memory's second cell.
+ */
+#define PROC_SAVE    ">A!."
+#define PROC_DOUBLE  "a4A"
+#define PROC_RESTORE "p=l.+p=a.p=p*"
+
 
-proc_t *proc_add(proc_t *root, char *name);
-void proc_call(FILE *output, proc_t *proc);
-void proc_ret(FILE *output, proc_t *proc);
+proc_t *proc_add(map_t *procs, char *name);
+void proc_call(out_t *output, proc_t *proc);
+void proc_ret(out_t *output, proc_t *proc);
+size_t proc_callsize(proc_t *proc);
+size_t proc_retsize(proc_t *proc);
 
 #endif /* _LIA_PROCEDURE_H */
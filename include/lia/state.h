@@ -0,0 +1,19 @@
+/**
+ * @file    state.h
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Header file declaring the tracking of known values
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ */
+#ifndef _LIA_STATE_H
+#define _LIA_STATE_H
+
+#include "lia/types.h"
+
+void state_reset(state_t *state);
+void state_track(state_t *state, const char *code, size_t length);
+void state_register(state_t *state, reg_t reg, int get);
+
+#endif /* _LIA_STATE_H */
@@ -13,7 +13,10 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <inttypes.h>
-#include "tree.h"
+#include "map.h"
+#include "arena.h"
+#include "strtab.h"
+#include "output.h"
 
 /** Token maximum size + 1 */
 #define TKMAX 129
@@ -28,8 +31,8 @@
 #define KEY_ARGS  token_t *tk, imp_t *file, lia_t *lia
 
 /** Arguments to target's functions */
-#define ARGTARGET FILE *output, lia_t *lia
-#define ARGCOMPILE FILE *output, inst_t *inst, lia_t *lia
+#define ARGTARGET out_t *output, lia_t *lia
+#define ARGCOMPILE out_t *output, inst_t *inst, lia_t *lia
 
 
 /** Enumeration to token's type. */
@@ -64,6 +67,25 @@ typedef enum token_type {
   TK_INVALID       /**< Must be the final value */
 } token_type_t;
 
+/** Registers, the value of a TK_REGISTER token */
+typedef enum reg {
+  REG_SS,
+  REG_RA,
+  REG_RB,
+  REG_RC,
+  REG_RD,
+  REG_RE,
+  REG_RF,
+  REG_RG,
+  REG_RH,
+  REG_RI,
+  REG_RJ,
+  REG_RK,
+  REG_RL,
+  REG_DP,
+  REG_NONE         /**< Must be the final value */
+} reg_t;
+
 /** Structure of a token */
 typedef struct token {
   struct token *next;
@@ -72,8 +94,11 @@ typedef struct token {
   int column;
 
   token_type_t type;
-  char text[TKMAX];
+  char *text;                  /**< Interned string */
+  unsigned long int hashname;  /**< Hash of the text */
   uint8_t value;
+  uint8_t key;                 /**< keyword_t of a TK_ID */
+  uint8_t metakey;             /**< metakeyword_t of a TK_ID */
 } token_t;
 
 
@@ -83,18 +108,33 @@ typedef struct cmd_arg {
   int type;
 } cmd_arg_t;
 
-/** Binary tree for commands */
+/** Marks a piece of a command's template as literal characters */
+#define CMD_LITERAL (-1)
+
+/** Piece of the compiled body of a command */
+typedef struct cmd_piece {
+  int slot;        /**< Index of the operand, or CMD_LITERAL */
+  bool get;        /**< If the register is read instead of written */
+  size_t offset;   /**< Offset of the literal characters */
+  size_t length;   /**< Length of the literal characters */
+} cmd_piece_t;
+
+/** A command */
 typedef struct cmd {
-  EXTENDS_TREE(cmd);
+  EXTENDS_MAP;
 
   cmd_arg_t args[CMD_ARGC];
   unsigned int argc;
   token_t *body;
+
+  char *literal;        /**< Literal characters of the body */
+  cmd_piece_t *pieces;  /**< The body compiled to a template */
+  unsigned int npieces;
 } cmd_t;
 
 /** Operand's union */
 typedef union operand {
-  char reg[5];
+  reg_t reg;
   uint8_t imm;
   char *procedure;
   token_t *string;
@@ -102,7 +142,7 @@ typedef union operand {
 
 
 typedef struct import {
-  EXTENDS_TREE(import);
+  EXTENDS_MAP;
   char filename[TKMAX];
   FILE *input;
 
@@ -129,24 +169,85 @@ typedef enum inst_type {
   INST_CMD
 } inst_type_t;
 
-/** Instructions' list generated by parser */
+/** Index marking the end of the instructions' list */
+#define INST_END (-1)
+
+/** Initial number of instructions allocated to the list */
+#define INSTLIST_SIZE 256
+
+/** Instruction generated by parser */
 typedef struct inst {
-  struct inst *next;
-  struct inst *last;
+  int next;        /**< Index of the next instruction, or INST_END */
   token_t *child;
   imp_t *file;
 
   inst_type_t type;
+  bool inline_hint; /**< `proc' hinted by [action inline] */
 } inst_t;
 
-/** Binary tree for procedures */
+/**
+ * Instructions' list, the instructions are stored in one contiguous
+ * array and linked by index.
+ */
+typedef struct instlist {
+  inst_t *inst;
+  int size;        /**< Number of instructions allocated */
+  int count;       /**< Number of instructions used */
+  int first;       /**< Index of the first instruction */
+  int last;        /**< Index of the last instruction */
+} instlist_t;
+
+/** A procedure */
 typedef struct proc {
-  EXTENDS_TREE(proc);
+  EXTENDS_MAP;
 
   unsigned int index;
+  int linear;        /**< Calls it with the linear encoding */
+  int defined;       /**< Its `proc' instruction was compiled */
   inst_t *body;
 } proc_t;
 
+/** Number of Ases registers tracked, `a' to `l' */
+#define STATE_REGS 12
+
+/**
+ * Values of the Ases accumulator and registers known at compile-time,
+ * each one is ACC_UNKNOWN if not known.
+ */
+typedef struct state {
+  long int acc;
+  long int reg[STATE_REGS];
+} state_t;
+
+/** A procedure's block at the instructions' list, used by the optimizer */
+typedef struct opt_proc {
+  EXTENDS_MAP;
+
+  int first;           /**< Index of the `proc' instruction */
+  int last;            /**< Index of the `endproc' instruction */
+  unsigned int order;  /**< Position at the source */
+  unsigned int calls;  /**< Number of static call sites */
+  int reached;         /**< Reachable from the main code */
+  unsigned int sites;  /**< Call sites that can be inlined */
+} opt_proc_t;
+
+/** Bit of the accumulator at the sets of registers of opt_effects_t */
+#define OPT_ACC (1U << STATE_REGS)
+
+/** All the registers and the accumulator */
+#define OPT_ALL ( (1U << (STATE_REGS + 1)) - 1 )
+
+/**
+ * Registers read and written by a instruction, bit `x' is the register
+ * `a' + x, used by the liveness analysis.
+ */
+typedef struct opt_effects {
+  unsigned int use;    /**< Read before written by the instruction */
+  unsigned int def;    /**< Always written by the instruction */
+  int pure;            /**< Has no effect other than writing `def' */
+  int barrier;         /**< Has control flow, nothing is known */
+} opt_effects_t;
+
 /** Path's list to search imported files */
 typedef struct path {
   struct path *next;
@@ -162,13 +263,14 @@ typedef struct ctx {
 } ctx_t;
 
 
-/** Macro argument */
-typedef struct macro_arg {
-  EXTENDS_TREE(macro);
+/** Marks a piece of a macro's template as a literal token */
+#define MACRO_LITERAL (-1)
 
-  token_type_t type;
-  token_t *body;
-} macro_arg_t;
+/** Piece of the compiled body of a macro's variant */
+typedef struct macro_piece {
+  int slot;        /**< Index of the argument, or MACRO_LITERAL */
+  token_t *tk;     /**< The literal token */
+} macro_piece_t;
 
 /** A list of token types that a macro receive */
 typedef struct mtk {
@@ -179,41 +281,91 @@ typedef struct mtk {
   char *name;
 } mtk_t;
 
-/** Variant of a macro */
+/** Variant of a macro, the name is the signature of its tokens' types */
 typedef struct macro_var {
-  EXTENDS_TREE(macro_var);
+  EXTENDS_MAP;
 
   mtk_t *tkseq;
   token_t *body;
+
+  macro_piece_t *pieces;  /**< The body compiled to a template */
+  unsigned int npieces;
 } macro_var_t;
 
-/** Macros' tree */
+/** Node of the trie of variants, indexed by the tokens' types */
+typedef struct macro_node {
+  struct macro_node *child[TK_INVALID];
+  macro_var_t *variant;   /**< The variant ending at this node, if any */
+} macro_node_t;
+
+/** A cached expansion of a macro */
+typedef struct macro_memo {
+  struct macro_memo *next;
+  unsigned long int hash;
+  unsigned long int generation;  /**< lia->generation when cached */
+
+  macro_var_t *variant;
+  char **args;                   /**< Interned text of the arguments */
+  size_t argc;
+  size_t start;                  /**< First of the parsed instructions */
+  size_t end;                    /**< One past the last instruction */
+} macro_memo_t;
+
+/** Cache of the expansions of the macros */
+typedef struct memo {
+  macro_memo_t **buckets;
+  size_t size;
+  size_t count;
+  size_t hits;
+  size_t misses;
+} memo_t;
+
+/** A macro */
 typedef struct macro {
-  EXTENDS_TREE(macro);
+  EXTENDS_MAP;
 
-  macro_var_t *variants;
+  map_t variants;
+  macro_node_t *trie;     /**< The variants indexed by its sequence */
 } macro_t;
 
 
 /** A Lia's struct reserving all informations about a code */
 typedef struct lia {
   struct target *target;
-  proc_t *proctree;    /**< The procedures' tree */
-  cmd_t *cmdtree;      /**< The commands' tree */
-  imp_t *imptree;      /**< The imports' tree */
-  macro_t *macrotree;  /**< Macros' tree */
-  inst_t *instlist;    /**< The instructions' list */
+  map_t procs;         /**< The procedures */
+  map_t cmds;          /**< The commands */
+  map_t imports;       /**< The imported files */
+  map_t macros;        /**< The macros */
+  instlist_t instlist; /**< The instructions' list */
   path_t *pathlist;    /**< The paths' list */
+  arena_t tkarena;     /**< Memory of the tokens */
+  strtab_t strtab;     /**< Interned strings of the tokens */
+
+  struct macro_frame *mstack; /**< Work stack of the macro's expansions */
+  size_t mdepth;              /**< Number of frames at the work stack */
+  size_t msize;               /**< Number of allocated frames */
+  size_t maxdepth;            /**< Maximum depth of expansions, 0 to default */
+  size_t maxgrowth;           /**< Maximum of expanded tokens, 0 to default */
+  size_t growth;              /**< Number of expanded tokens */
+  size_t mnest;               /**< Number of `expr' bodies being parsed */
+
+  memo_t memo;                /**< Cache of the expansions */
+  unsigned long int generation; /**< Changes when a macro or command is set */
   
   ctx_t *ctx;        /**< Context for blocks instructions. */
   proc_t *inproc;    /**< Define context inside a procedure. */
   inst_t *thisproc;
+  state_t state;     /**< Known values after the last instruction compiled */
+  token_t *inlinenext; /**< [action inline] hinting the next procedure */
   unsigned int errcount;
 } lia_t;
 
 /** Target to generates final code */
 typedef struct target {
   int pretty;
+  int strcache;      /**< Caches a character of the strings at mem[p] */
+  int linearcall;    /**< Uses the linear encoding of the procedure's calls */
+  unsigned long int peephole;  /**< Mask of the enabled peephole's rules */
   const char *name;
 
   /** Initializes the code */
@@ -0,0 +1,40 @@
+#ifndef _MAP_H
+#define _MAP_H
+
+#include <stddef.h>
+
+#define INITIAL_HASH 5381
+
+/** Initial number of slots of a map */
+#define MAP_SIZE 16
+
+/** Macro to expand basic struct elements of a map's element */
+#define EXTENDS_MAP            \
+  unsigned long int hashname; \
+  char *name
+
+/** A basic element of a map */
+typedef struct map_elem {
+  EXTENDS_MAP;
+} map_elem_t;
+
+/** Slot of a map */
+typedef struct map_slot {
+  unsigned long int hashname;
+  void *elem;                  /**< NULL if the slot is empty */
+} map_slot_t;
+
+/** Hash map using open addressing and Robin Hood hashing */
+typedef struct map {
+  map_slot_t *slots;
+  size_t size;        /**< Number of slots, zero or a power of two */
+  size_t count;       /**< Number of elements */
+} map_t;
+
+unsigned long int hash(char *str);
+void *map_insert(map_t *map, size_t size, unsigned long int hashname, char *name);
+void *map_find(map_t *map, unsigned long int hashname, const char *name);
+void map_free(map_t *map);
+void map_map(map_t *map, void (*mapper)(void *));
+
+#endif /* _MAP_H */
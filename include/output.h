@@ -0,0 +1,48 @@
+#ifndef _OUTPUT_H
+#define _OUTPUT_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/** Size of the buffer of a file's output, and initial size of a memory's */
+#define OUT_BUFSIZE 65536
+
+struct out;
+
+/** Where an output's bytes go to */
+typedef struct sink {
+  /** Receives the bytes that don't fit at the buffer */
+  void (*write)(struct out *out, const void *data, size_t size);
+
+  /** Receives a run of the same character that don't fit at the buffer */
+  void (*repeat)(struct out *out, int ch, size_t n);
+
+  /** Writes the buffered bytes, returns 0 if all ok */
+  int (*flush)(struct out *out);
+} sink_t;
+
+/** An output, writing through a sink */
+typedef struct out {
+  const sink_t *sink;
+  FILE *file;     /**< The file of a file's output */
+  char *buf;
+  size_t len;     /**< Number of bytes at the buffer */
+  size_t size;    /**< Allocated size of the buffer */
+  size_t pos;     /**< Number of bytes that left the buffer */
+  int error;      /**< EOF if a write to the file failed */
+} out_t;
+
+void out_file(out_t *out, FILE *file);
+void out_memory(out_t *out);
+void out_counter(out_t *out);
+
+void out_putc(out_t *out, int ch);
+void out_puts(out_t *out, const char *str);
+void out_write(out_t *out, const void *data, size_t size);
+void out_repeat(out_t *out, int ch, size_t n);
+void out_printf(out_t *out, const char *fmt, ...);
+size_t out_tell(out_t *out);
+int out_flush(out_t *out);
+void out_free(out_t *out);
+
+#endif /* _OUTPUT_H */
@@ -0,0 +1,32 @@
+#ifndef _STRTAB_H
+#define _STRTAB_H
+
+#include <stddef.h>
+#include "arena.h"
+
+/** Initial number of buckets of the strings' table */
+#define STRTAB_SIZE 1024
+
+/** Gets the istr_t of a interned string */
+#define ISTR(str) ( (istr_t *) ((str) - offsetof(istr_t, text)) )
+
+/** A interned string, prefixed by its length and hash */
+typedef struct istr {
+  struct istr *next;
+  unsigned long int hash;
+  size_t length;
+  char text[];
+} istr_t;
+
+/** Table of interned strings, each string is stored only once */
+typedef struct strtab {
+  istr_t **buckets;
+  size_t size;       /**< Number of buckets, always a power of two */
+  size_t count;      /**< Number of strings in the table */
+  arena_t arena;     /**< Memory of the strings */
+} strtab_t;
+
+char *strtab_intern(strtab_t *tab, const char *str, size_t length);
+void strtab_free(strtab_t *tab);
+
+#endif /* _STRTAB_H */
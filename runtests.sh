@@ -6,6 +6,8 @@ make test name=compiler || exit
 make test name=cmd || exit
 make test name=procedure || exit
 make test name=macros || exit
+make test name=peephole || exit
+make test name=output || exit
 bash tests/test_modules.sh || exit
 
 echo "* Test finished without errors *"
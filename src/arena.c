@@ -0,0 +1,65 @@
+/**
+ * @file    arena.c
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Bump-pointer allocator using slabs
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "arena.h"
+
+/**
+ * @brief Allocates zeroed memory in the arena
+ * 
+ * The memory can't be freed alone, only with arena_free(). Exits if out
+ * of memory.
+ * 
+ * @param arena    The arena
+ * @param size     The size to allocate
+ * @return void*   Pointer to the memory
+ */
+void *arena_alloc(arena_t *arena, size_t size)
+{
+  slab_t *slab = arena->slab;
+  void *ret;
+
+  size = (size + sizeof (max_align_t) - 1) & ~(sizeof (max_align_t) - 1);
+
+  if ( !slab || slab->size - slab->used < size ) {
+    size_t slabsize = (size > SLAB_SIZE) ? size : SLAB_SIZE;
+
+    slab = calloc(1, sizeof *slab + slabsize);
+    if ( !slab ) {
+      fputs("Arena: Out of memory\n", stderr);
+      exit(EXIT_FAILURE);
+    }
+
+    slab->size = slabsize;
+    slab->next = arena->slab;
+    arena->slab = slab;
+  }
+
+  ret = (char *) slab->data + slab->used;
+  slab->used += size;
+  return ret;
+}
+
+/**
+ * @brief Free all the memory of the arena
+ * 
+ * @param arena  The arena
+ */
+void arena_free(arena_t *arena)
+{
+  slab_t *next;
+
+  for (slab_t *this = arena->slab; this; this = next) {
+    next = this->next;
+    free(this);
+  }
+
+  arena->slab = NULL;
+}
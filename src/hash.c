@@ -8,7 +8,7 @@
  * @copyright Copyright (c) 2020 Luiz Felipe
  * 
  */
-#include "tree.h"
+#include "map.h"
 
 /**
  * @brief Hash a string using djb2 algorithm
@@ -25,17 +25,3 @@ unsigned long int hash(char *str)
 
   return hash;
 }
-
-/**
- * @brief Hashing using a cumulative sequence of values
- * 
- * @param output  The variable to writes the output hash
- * @param n       The number to hash.
- */
-void hashint(unsigned long int *output, int n)
-{
-  if ( *output == 0 )
-    *output = INITIAL_HASH;
-  
-  *output = ( (*output << 5) + *output ) + n;
-}
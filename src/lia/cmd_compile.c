@@ -12,87 +12,288 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 #include "lia/lia.h"
+#include "lia/imm_table.h"
+#include "lia/chr_table.h"
+
+/** imm_compile_state() loading from the table instead of a known value */
+#define IMM_TABLE (-2)
 
 /**
  * @brief Generate the code to get or set a register
  * 
- * @param output   The file to write
- * @param reg      The register's name
+ * @param output   The output to write
+ * @param reg      The register
  * @param get      0 to set, nonzero to get
  * @return 0       If register not exists
  * @return nonzero If all ok
  */
-int reg_compile(FILE *output, char *reg, int get)
+int reg_compile(out_t *output, reg_t reg, int get)
 {
-  char result;
-  if ( !strcmp(reg, "ss") )
-    return 1;
-  
-  if ( !strcmp(reg, "dp") ) {
-    result = 'p';
-  } else if (reg[0] == 'r'){
-    result = reg[1];
-  } else {
+  static const char setlist[] = {
+    [REG_SS] = 0,
+    [REG_RA] = 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l',
+    [REG_DP] = 'p'
+  };
+  static const char getlist[] = {
+    [REG_SS] = 0,
+    [REG_RA] = 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L',
+    [REG_DP] = 'P'
+  };
+
+  if (reg >= REG_NONE)
     return 0;
-  }
 
-  if (get) {
-    putc(toupper(result), output);
-  } else {
-    putc(result, output);
-  }
+  if (reg != REG_SS)
+    out_putc(output, get ? getlist[reg] : setlist[reg]);
 
   return 1;
 }
 
+/**
+ * @brief Calculates the length of the code to add a value to the accumulator
+ * 
+ * @param delta     The value to add, can be negative
+ * @return size_t   The number of instructions
+ */
+size_t delta_length(long int delta)
+{
+  unsigned long int total = (delta < 0) ? -delta : delta;
+
+  if (total % 10 > 5)
+    return total/10 + 1 + 10 - total % 10;
+
+  return total/10 + total % 10;
+}
+
+/**
+ * @brief Generate code to add a value to the accumulator
+ * 
+ * @param output   The output to write the instruction
+ * @param delta    The value to add, can be negative
+ */
+void delta_compile(out_t *output, long int delta)
+{
+  int index = (delta < 0);
+  unsigned long int total = index ? -delta : delta;
+
+  out_repeat(output, "67"[index], total/10);
+  total %= 10;
+
+  if (total > 5) {
+    out_putc(output, "67"[index]);
+    out_repeat(output, "-+"[index], 10 - total);
+  } else {
+    out_repeat(output, "+-"[index], total);
+  }
+}
+
 /**
  * @brief Generate code to set a immediate value
  * 
- * @param output   The file to write the instruction
+ * The shortest sequence to each value is taken from imm_table, generated
+ * by tools/immtab.c.
+ * 
+ * @param output   The output to write the instruction
  * @param imm      The value
  */
-void imm_compile(FILE *output, uint8_t imm)
+void imm_compile(out_t *output, uint8_t imm)
 {
-  putc('.', output);
+  out_write(output, imm_table[imm], imm_length[imm]);
+}
+
+/**
+ * @brief Generate code to set a immediate value, from the known values
+ * 
+ * The value is reached from the accumulator, or loading a register and
+ * changing it, whichever is shorter. Or set from zero if none is known.
+ * 
+ * @param output   The output to write the instruction
+ * @param state    The known values
+ * @param imm      The value
+ */
+void imm_compile_state(out_t *output, const state_t *state, uint8_t imm)
+{
+  size_t best = imm_length[imm];
+  size_t length;
+  long int value;
+  long int delta;
+  long int bestdelta = 0;
+  int from = IMM_TABLE;
 
-  for (int i = 0; i < imm/10; i++)
-    putc('6', output);
-  
+  // -1 is the accumulator, the others are the registers.
+  for (int i = -1; i < STATE_REGS; i++) {
+    value = (i < 0) ? state->acc : state->reg[i];
+    if (value == ACC_UNKNOWN)
+      continue;
 
-  unsigned int total = imm%10;
+    /* The accumulator has 16 bits, the shorter way can wrap around */
+    delta = ((long int) imm - value) & 0xffff;
+    if (delta > 0x8000)
+      delta -= 0x10000;
 
-  if (total > 5) {
-    putc('6', output);
+    length = delta_length(delta) + (i >= 0);
+    if (length < best) {
+      best = length;
+      bestdelta = delta;
+      from = i;
+    }
+  }
 
-    for (int i = 10 - total; i > 0; i--)
-      putc('-', output);
-  } else {
-    for (int i = total; i > 0; i--)
-      putc('+', output);
+  if (from == IMM_TABLE) {
+    imm_compile(output, imm);
+    return;
   }
+
+  if (from >= 0)
+    out_putc(output, 'A' + from);
+
+  delta_compile(output, bestdelta);
+}
+
+/**
+ * @brief Generate the code to change the character at the accumulator
+ * 
+ * @param output  The output to write
+ * @param from    The character at the accumulator
+ * @param to      The character to set
+ */
+static void chr_compile(out_t *output, int from, int to)
+{
+  uint16_t entry = chr_table[from][to];
+
+  if ( CHR_RESET(entry) )
+    out_putc(output, '.');
+
+  out_repeat(output, CHR_TENSCH(entry), CHR_TENS(entry));
+  out_repeat(output, CHR_ONESCH(entry), CHR_ONES(entry));
+}
+
+/**
+ * @brief Compiles a text keeping a second character cached at the memory
+ * pointed by `p'. Each character is chosen between changing the accumulator
+ * or loading the cache and changing it, minimizing the total length.
+ * 
+ * @param output  The output to writes the code
+ * @param text    The text to compile
+ * @param length  Length of the text
+ * @param acc     The character at the accumulator
+ * @return 0       If memory allocation fails
+ * @return nonzero If all ok
+ */
+static int str_compile_cached(out_t *output, const uint8_t *text, size_t length,
+  int acc)
+{
+  enum { NONE = 256, STATES = 257 };
+  enum { STORE = 1, LOAD = 2 };
+  struct { uint16_t from; uint8_t how; } *back;
+  unsigned long cost[STATES];
+  unsigned long next[STATES];
+  unsigned long total;
+  int start = acc;
+  int state;
+
+  back = malloc(sizeof *back * STATES * length);
+  if ( !back )
+    return 0;
+
+  for (state = 0; state < STATES; state++)
+    cost[state] = ULONG_MAX;
+  cost[NONE] = 0;
+
+  for (size_t i = 0; i < length; i++) {
+    for (state = 0; state < STATES; state++)
+      next[state] = ULONG_MAX;
+
+    for (int from = 0; from < STATES; from++) {
+      if (cost[from] == ULONG_MAX)
+        continue;
+
+      for (int store = 0; store < 2; store++) {
+        int cache = store ? acc : from;
+        int how = store ? STORE : 0;
+
+        total = cost[from] + store + CHR_LENGTH(chr_table[acc][text[i]]);
+        if (cache != NONE
+            && 1 + CHR_LENGTH(chr_table[cache][text[i]])
+               < CHR_LENGTH(chr_table[acc][text[i]]) ) {
+          total = cost[from] + store + 1 + CHR_LENGTH(chr_table[cache][text[i]]);
+          how |= LOAD;
+        }
+
+        if (total < next[cache]) {
+          next[cache] = total;
+          back[i*STATES + cache].from = from;
+          back[i*STATES + cache].how = how;
+        }
+      }
+    }
+
+    memcpy(cost, next, sizeof cost);
+    acc = text[i];
+  }
+
+  state = NONE;
+  for (int i = 0; i < STATES; i++) {
+    if (cost[i] < cost[state])
+      state = i;
+  }
+
+  // Walks back the choices, saving the cache value before each character.
+  for (size_t i = length; i-- > 0;) {
+    int from = back[i*STATES + state].from;
+    back[i*STATES].how = back[i*STATES + state].how;
+    back[i*STATES].from = state;
+    state = from;
+  }
+
+  acc = start;
+  for (size_t i = 0; i < length; i++) {
+    int how = back[i*STATES].how;
+    int cache = back[i*STATES].from;
+
+    if (how & STORE)
+      out_putc(output, '!');
+
+    if (how & LOAD) {
+      out_putc(output, '=');
+      chr_compile(output, cache, text[i]);
+    } else {
+      chr_compile(output, acc, text[i]);
+    }
+
+    out_putc(output, '1');
+    acc = text[i];
+  }
+
+  free(back);
+  return 1;
 }
 
 /**
  * @brief Compiles a string at a sequence of output
  * 
  * @param filename  The filename.
- * @param output    The file to writes the output.
+ * @param output    The output to writes the code.
  * @param tk        The token to reads the text.
+ * @param cache     Nonzero to keep a second character cached at the
+ *                  memory pointed by `p', clobbering it.
+ * @param acc       The value at the accumulator, or ACC_UNKNOWN
  * @return token_t* Last string token compiled.
  * @return NULL     If error.
  */
-token_t *str_compile(char *filename, FILE *output, token_t *tk)
+token_t *str_compile(char *filename, out_t *output, token_t *tk, int cache,
+  long int acc)
 {
-  int index;
-  int diff;
-  int chone[] = {'+', '-'};
-  int chten[] = {'6', '7'};
-  int last = 0;
-  putc('.', output);
+  uint8_t *text = NULL;
+  size_t length = 0;
+  size_t size = 0;
+  int last;
+  int ch;
 
   while (tk->type == TK_STRING) {
-    for (int ch, i = 0; tk->text[i]; i++) {
+    for (int i = 0; tk->text[i]; i++) {
       if (tk->text[i] == '\\') {
         i++;
         ch = chresc(tk->text[i]);
@@ -100,35 +301,26 @@ token_t *str_compile(char *filename, FILE *output, token_t *tk)
           lia_error(filename, tk->line, tk->column + i + 1,
             "Invalid escape '\\%c' at string.", tk->text[i]);
 
+          free(text);
           return NULL;
         }
       } else {
         ch = tk->text[i];
       }
 
-      diff = abs(last - ch);
-      if ( !diff ) {
-        putc('1', output);
-        continue;
-      }
+      if (length >= size) {
+        size = size ? size * 2 : 64;
 
-      index = (last > ch);
-      for (int i = 0; i < diff/10; i++)
-        putc(chten[index], output);
-      
-      unsigned int total = diff%10;
-      if (total > 5) {
-        putc(chten[index], output);
+        uint8_t *new = realloc(text, size);
+        if ( !new ) {
+          fputs("Compiler: Out of memory\n", stderr);
+          exit(EXIT_FAILURE);
+        }
 
-        for (int i = 10 - total; i > 0; i--)
-          putc(chone[ !index ], output);
-      } else {
-        for (int i = total; i > 0; i--)
-          putc(chone[index], output);
+        text = new;
       }
-    
-      putc('1', output);
-      last = ch;
+
+      text[length++] = ch;
     }
 
     if ( !tk->next )
@@ -137,85 +329,75 @@ token_t *str_compile(char *filename, FILE *output, token_t *tk)
     tk = metanext(tk);
   }
 
-  return tk;
-}
+  if (acc == ACC_UNKNOWN || acc > UINT8_MAX) {
+    out_putc(output, '.');
+    acc = 0;
+  }
 
-/**
- * @brief Verify if a token is a valid register name
- * 
- * @param tk    The token to verify
- * @return int  0 if not, nonzero if yes
- */
-int isreg(token_t *tk)
-{
-  if (tk->type != TK_ID)
-    return 0;
-  
-  if ( !strcmp(tk->text, "ss") )
-    return 1;
-  if ( !strcmp(tk->text, "dp") )
-    return 1;
-  
-  if (tk->text[0] == 'r') {
-    if (tk->text[1] >= 'a' && tk->text[1] <= 'l' && !tk->text[2])
-      return 1;
+  last = acc;
+  if ( !cache || !str_compile_cached(output, text, length, acc) ) {
+    for (size_t i = 0; i < length; i++) {
+      chr_compile(output, last, text[i]);
+      out_putc(output, '1');
+      last = text[i];
+    }
   }
 
-  return 0;
+  free(text);
+  return tk;
 }
 
 /**
  * @brief Compile a command in the Ases code
  * 
- * @param proctree The tree of procedures
- * @param output   The file to write the code
+ * @param procs    The map of procedures
+ * @param output   The output to write the code
  * @param cmd      The command to compile
  * @param ops      The operands
+ * @param state    The known values before the command, or NULL
  * @return nonzero If all ok
  * @return 0       If error
  */
-int lia_cmd_compile(proc_t *proctree, char *filename, FILE *output, cmd_t *cmd, operand_t *ops)
+int lia_cmd_compile(map_t *procs, char *filename, out_t *output, cmd_t *cmd,
+  operand_t *ops, const state_t *state)
 {
-  token_t *tk;
-  int index;
-  char *position;
+  cmd_piece_t *piece;
+  state_t known;
 
   if (!cmd || !ops)
     return 0;
 
-  char arglist[] = {
-    tolower(cmd->args[0].name),
-    tolower(cmd->args[1].name),
-    tolower(cmd->args[2].name),
-    0
-  };
+  if (state)
+    known = *state;
+  else
+    state_reset(&known);
 
-  for (tk = cmd->body; tk && tk->type == TK_STRING; tk = metanext(tk)) {
-    for (int i = 0; tk->text[i]; i++) {
-      position = strchr( arglist, tolower(tk->text[i]) );
-
-      if (position) {
-        index = (int) (position - arglist);
-
-        switch (cmd->args[index].type) {
-        case 'r':
-          reg_compile( output, ops[index].reg, isupper(tk->text[i]) );
-          break;
-        case 'i':
-          imm_compile(output, ops[index].imm);
-          break;
-        case 'p':
-          proc_call( output, proc_add(proctree, ops[index].procedure) );
-          break;
-        case 's':
-          str_compile(filename, output, ops[index].string);
-          break;
-        default:
-          return 0;
-        }
-      } else {
-        putc(tk->text[i], output);
-      }
+  for (piece = cmd->pieces; piece < cmd->pieces + cmd->npieces; piece++) {
+    if (piece->slot == CMD_LITERAL) {
+      out_write(output, cmd->literal + piece->offset, piece->length);
+      state_track(&known, cmd->literal + piece->offset, piece->length);
+      continue;
+    }
+
+    switch (cmd->args[piece->slot].type) {
+    case 'r':
+      reg_compile(output, ops[piece->slot].reg, piece->get);
+      state_register(&known, ops[piece->slot].reg, piece->get);
+      break;
+    case 'i':
+      imm_compile_state(output, &known, ops[piece->slot].imm);
+      known.acc = ops[piece->slot].imm;
+      break;
+    case 'p':
+      proc_call( output, proc_add(procs, ops[piece->slot].procedure) );
+      state_reset(&known);
+      break;
+    case 's':
+      str_compile(filename, output, ops[piece->slot].string, 0, known.acc);
+      known.acc = ACC_UNKNOWN;
+      break;
+    default:
+      return 0;
     }
   }
 
@@ -13,25 +13,85 @@
 #include <ctype.h>
 #include <string.h>
 #include "lia/cmd.h"
+#include "lia/parser.h"
 
 /**
- * @brief Inserts a new instruction in the tree.
+ * @brief Compiles the body of a command to a template.
+ * 
+ * The template is a sequence of literal runs and operands' slots,
+ * so the body is not parsed again at each use of the command.
+ * 
+ * @param cmd   The command
+ */
+static void cmd_template(cmd_t *cmd)
+{
+  token_t *tk;
+  char *position;
+  cmd_piece_t *literal = NULL;
+  size_t size = 1;
+
+  char arglist[] = {
+    tolower(cmd->args[0].name),
+    tolower(cmd->args[1].name),
+    tolower(cmd->args[2].name),
+    0
+  };
+
+  for (tk = cmd->body; tk && tk->type == TK_STRING; tk = metanext(tk))
+    size += strlen(tk->text);
+
+  free(cmd->literal);
+  free(cmd->pieces);
+  cmd->literal = malloc(size);
+  cmd->pieces = malloc(size * sizeof *cmd->pieces);
+  cmd->npieces = 0;
+
+  size = 0;
+  for (tk = cmd->body; tk && tk->type == TK_STRING; tk = metanext(tk)) {
+    for (int i = 0; tk->text[i]; i++) {
+      position = strchr( arglist, tolower(tk->text[i]) );
+
+      if (position) {
+        cmd->pieces[cmd->npieces++] = (cmd_piece_t) {
+          .slot = position - arglist,
+          .get = isupper(tk->text[i])
+        };
+        literal = NULL;
+        continue;
+      }
+
+      if ( !literal ) {
+        literal = &cmd->pieces[cmd->npieces++];
+        *literal = (cmd_piece_t) {
+          .slot = CMD_LITERAL,
+          .offset = size
+        };
+      }
+
+      cmd->literal[size++] = tk->text[i];
+      literal->length++;
+    }
+  }
+}
+
+/**
+ * @brief Inserts a new command in the map.
  * 
  * If the command exists, overwrite it.
  * 
- * @param tree     The tree root of commands
+ * @param cmds     The map of commands
  * @param name     Name of the new command
  * @param args     Array of arguments
  * @param body     Body of the command
  * @return cmd_t*  Pointer to the new element
  */
-cmd_t *lia_cmd_new(cmd_t *tree, char *name, cmd_arg_t *args, token_t *body)
+cmd_t *lia_cmd_new(map_t *cmds, char *name, cmd_arg_t *args, token_t *body)
 {
   unsigned long int hashname = hash(name);
-  cmd_t *new = tree_find(tree, hashname);
+  cmd_t *new = map_find(cmds, hashname, name);
 
   if ( !new )
-    new = tree_insert(tree, sizeof *new, hashname);
+    new = map_insert(cmds, sizeof *new, hashname, name);
 
   new->name = name;
   memcpy(new->args, args, sizeof *args * CMD_ARGC);
@@ -40,6 +100,8 @@ cmd_t *lia_cmd_new(cmd_t *tree, char *name, cmd_arg_t *args, token_t *body)
   new->argc = 0;
   while (new->argc < CMD_ARGC && args[new->argc].name)
     new->argc++;
+
+  cmd_template(new);
   
   return new;
 }
@@ -13,8 +13,9 @@
 #include <string.h>
 #include "lia/lia.h"
 #include "lia/target.h"
-#include "tree.h"
+#include "map.h"
 
+bool lia_silent = false;
 
 /**
  * @brief Push new context to stack.
@@ -62,18 +63,17 @@ ctx_t *lia_ctx_pop(lia_t *lia)
  */
 imp_t *lia_process(char *filename, FILE *input, lia_t *lia)
 {
-  if ( !lia->imptree )
-    lia->imptree = calloc(1, sizeof (imp_t));
-
-  imp_t *file = tree_insert(lia->imptree, sizeof (imp_t), hash(filename));
+  imp_t *file = map_insert(&lia->imports, sizeof (imp_t), hash(filename),
+    filename);
 
   if ( !file )
     return NULL;
   
   strcpy(file->filename, filename);
+  file->name = file->filename;
   file->input = input;
 
-  file->tklist = lia_lexer(filename, input);
+  file->tklist = lia_lexer(filename, input, lia);
 
   if ( !file->tklist ) {
     lia->errcount++;
@@ -84,71 +84,107 @@ imp_t *lia_process(char *filename, FILE *input, lia_t *lia)
   return file;
 }
 
+/** Writes the code of a instruction to the output, emptying the chunk */
+static void chunk_write(out_t *output, out_t *chunk)
+{
+  out_write(output, chunk->buf, chunk->len);
+  chunk->len = 0;
+}
+
 /**
  * @brief Compile the lia_t struct to final code.
  * 
- * @param output    The file to writes the code.
+ * @param output    The output to writes the code.
  * @param lia       The lia_t struct.
  * @param target    Target to generate the code.
  * @return int      The number of errors.
  */
-int lia_compiler(FILE *output, lia_t *lia)
+int lia_compiler(out_t *output, lia_t *lia)
 {
   if (!output || !lia) {
     fputs("Compiler: Invalid call", stderr);
     return 9999;
   }
 
-  inst_t *next;
-  inst_t *this = lia->instlist;
-  inst_t *last = this;
+  instlist_t *list = &lia->instlist;
+  inst_t *this;
+  int *link = &list->first;
+  int next;
+  int dead;
+  int unreachable;
+  out_t discard;
+  out_t chunk;
+  out_t buffer;
+  out_t *final = output;
   
-  if ( !this || !this->child )
+  if ( !list->count )
     return lia->errcount;
+
+  unreachable = opt_unreachable(lia);
+  opt_inline(lia);
+  dead = opt_deadprocs(lia);
+  opt_procorder(lia);
+  opt_deadstores(lia);
+  opt_declare(lia, list->first);
+  opt_declare(lia, dead);
+
+  // The peephole optimizer needs all the code in memory.
+  if (lia->target->peephole) {
+    out_memory(&buffer);
+    output = &buffer;
+  }
+
+  // Each instruction is compiled to memory, where the target follows the
+  // known values, then written to the output.
+  out_memory(&chunk);
+  state_reset(&lia->state);
   
   lia->target->start(output, lia);
 
-  // Compiling the procedures first.
-  for (; this; this = next) {
+  // Compiling the procedures first, unlinking them from the list.
+  for (int i = list->first; i != INST_END; i = next) {
+    this = &list->inst[i];
+
     if (this->type != INST_PROC) {
-      last = this;
+      link = &this->next;
       next = this->next;
       continue;
     }
 
     while (this->type != INST_ENDPROC) {
-      this = lia->target->compile(output, this, lia);
+      this = lia->target->compile(&chunk, this, lia);
+      chunk_write(output, &chunk);
 
-      if ( !this->next )
+      if (this->next == INST_END)
         break;
 
-      this = this->next;
+      this = &list->inst[this->next];
     }
 
-    this = lia->target->compile(output, this, lia);
+    this = lia->target->compile(&chunk, this, lia);
+    chunk_write(output, &chunk);
     next = this->next;
+    *link = next;
+  }
 
-    if ( !next || next->type != INST_PROC ) {
-      if ( last == lia->instlist && last->type == INST_PROC )
-        lia->instlist = next;
-      else
-        last->next = next;
-
-      last = next;
-    }
-
-    this->next = NULL;
+  for (int i = list->first; i != INST_END; i = this->next) {
+    this = lia->target->compile(&chunk, &list->inst[i], lia);
+    chunk_write(output, &chunk);
   }
 
-  this = lia->instlist;
-  while (this) {
-    this = lia->target->compile(output, this, lia);
+  out_free(&chunk);
 
-    if ( !this->next )
-      break;
+  // The unreachable procedures and code are compiled only to report its
+  // errors.
+  out_counter(&discard);
+  for (int i = dead; i != INST_END; i = this->next) {
+    this = lia->target->compile(&discard, &list->inst[i], lia);
+  }
 
-    this = this->next;
+  for (int i = unreachable; i != INST_END; i = this->next) {
+    this = lia->target->compile(&discard, &list->inst[i], lia);
   }
+  out_free(&discard);
 
   if (lia->inproc) {
     this = lia->thisproc;
@@ -175,5 +211,12 @@ int lia_compiler(FILE *output, lia_t *lia)
   }
 
   lia->target->end(output, lia);
+
+  if (lia->target->peephole) {
+    buffer.len = peep_optimize(buffer.buf, buffer.len, lia->target->peephole);
+    out_write(final, buffer.buf, buffer.len);
+    out_free(&buffer);
+  }
+
   return lia->errcount;
 }
@@ -8,49 +8,67 @@
  * @copyright Copyright (c) 2020 Luiz Felipe
  */
 #include <stdlib.h>
+#include <string.h>
 #include "lia/types.h"
-#include "tree.h"
+#include "lia/memo.h"
+#include "map.h"
 
 /**
- * @brief Free a token list
+ * @brief Free a instruction list.
+ * 
+ * The tokens are not freed here, they are in the tokens' arena.
  * 
- * @param tk   Pointer to the first item in the list
+ * @param list   The list to free.
  */
-void tkfree(token_t *tk)
+void inst_free(instlist_t *list)
 {
-  if ( !tk )
-    return;
+  free(list->inst);
+  memset(list, 0, sizeof *list);
+}
 
-  while (tk->next) {
-    tk = tk->next;
-    free(tk->last);
-  }
+/**
+ * @brief Free the sequence of tokens' types of a variant.
+ * 
+ * This function can be used with map_map().
+ * 
+ * @param variant   The variant of a macro.
+ */
+static void variant_free(void *variant)
+{
+  mtk_t *next;
 
-  free(tk);
+  for (mtk_t *this = ((macro_var_t *) variant)->tkseq; this; this = next) {
+    next = this->next;
+    free(this);
+  }
 }
 
 /**
- * @brief Free a instruction list.
+ * @brief Free the variants of a macro.
  * 
- * @param list   The list to free.
+ * This function can be used with map_map().
+ * 
+ * @param macro   The macro.
  */
-void inst_free(inst_t *list)
+void macro_free(void *macro)
 {
-  inst_t *inst_next;
-  token_t *token_next;
-  token_t *this;
-
-  while (list) {
-    inst_next = list->next;
+  map_t *variants = &((macro_t *) macro)->variants;
 
-    for (this = list->child; this; this = token_next) {
-      token_next = this->next;
-      free(this);
-    }
+  map_map(variants, variant_free);
+  map_free(variants);
+}
 
-    free(list);
-    list = inst_next;
-  }
+/**
+ * @brief Free the compiled body of a command.
+ * 
+ * This function can be used with map_map().
+ * 
+ * @param cmd   The command.
+ */
+void cmd_free(void *cmd)
+{
+  free( ((cmd_t *) cmd)->literal );
+  free( ((cmd_t *) cmd)->pieces );
 }
 
 /**
@@ -65,11 +83,18 @@ void lia_free(lia_t *lia)
   if ( !lia )
     return;
 
-  tree_free(lia->proctree);
-  tree_free(lia->imptree);
-  tree_free(lia->cmdtree);
+  map_free(&lia->procs);
+  map_free(&lia->imports);
+  map_map(&lia->cmds, cmd_free);
+  map_free(&lia->cmds);
+  map_map(&lia->macros, macro_free);
+  map_free(&lia->macros);
+  free(lia->mstack);
+  memo_free(&lia->memo);
 
-  inst_free(lia->instlist);
+  inst_free(&lia->instlist);
+  arena_free(&lia->tkarena);
+  strtab_free(&lia->strtab);
   
   for (path_t *this = lia->pathlist; this; this = next) {
     next = this->next;
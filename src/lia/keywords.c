@@ -12,9 +12,60 @@
 #include <string.h>
 #include "lia/lia.h"
 
+/** Perfect hash of the keywords' names, with length >= 2 */
+#define KEYHASH(name, length) \
+  ( ((length) * 6 + (unsigned char) (name)[0] + \
+    (unsigned char) (name)[1] * 4) & 31 )
+
+/**
+ * @brief Converts a name to the keyword.
+ * 
+ * KEYHASH() has no collisions between the keywords, so the name is
+ * compared with one keyword at most.
+ * 
+ * @param name          The name, don't need to be null-terminated
+ * @param length        Length of the name
+ * @return keyword_t    The keyword's type
+ * @return KEY_NONE     If is not a keyword
+ */
+keyword_t name2key(const char *name, size_t length)
+{
+  static const struct {
+    const char *name;
+    keyword_t type;
+  } list[32] = {
+    [0]  = { "load",    KEY_LOAD },
+    [1]  = { "store",   KEY_STORE },
+    [5]  = { "ases",    KEY_ASES },
+    [7]  = { "endproc", KEY_ENDPROC },
+    [9]  = { "say",     KEY_SAY },
+    [16] = { "proc",    KEY_PROC },
+    [18] = { "func",    KEY_FUNC },
+    [19] = { "ifz",     KEY_IF },
+    [24] = { "ret",     KEY_RET },
+    [25] = { "ifnz",    KEY_IF },
+    [27] = { "endif",   KEY_ENDIF },
+    [28] = { "push",    KEY_PUSH },
+    [30] = { "pop",     KEY_POP },
+    [31] = { "call",    KEY_CALL }
+  };
+
+  if (length < 2)
+    return KEY_NONE;
+
+  int i = KEYHASH(name, length);
+  if ( !list[i].name || strncmp(list[i].name, name, length) ||
+       list[i].name[length] )
+    return KEY_NONE;
+
+  return list[i].type;
+}
+
 /**
  * @brief Verify if a token is a keyword
  * 
+ * The keyword is recognized at the lexer.
+ * 
  * @param tk            The token to verify
  * @return keyword_t    The keyword's type
  * @return KEY_NONE     If is not a keyword
@@ -23,40 +74,15 @@ keyword_t iskey(token_t *tk)
 {
   if (tk->type != TK_ID)
     return KEY_NONE;
-  
-  if ( !strcmp(tk->text, "ifz") || !strcmp(tk->text, "ifnz") )
-    return KEY_IF;
-
-  const char *list[] = {
-    [KEY_FUNC] = "func",
-    [KEY_LOAD] = "load",
-    [KEY_STORE] = "store",
-    [KEY_PUSH] = "push",
-    [KEY_POP] = "pop",
-    [KEY_CALL] = "call",
-    [KEY_RET] = "ret",
-    [KEY_PROC] = "proc",
-    [KEY_ENDPROC] = "endproc",
-    [KEY_IF] = "",
-    [KEY_ENDIF] = "endif",
-    [KEY_SAY] = "say",
-    [KEY_ASES] = "ases",
-    [KEY_NONE] = NULL,
-  };
-  
-  for (int i = 0; list[i]; i++) {
-    if ( !strcmp(list[i], tk->text) )
-      return i;
-  }
-  
-  return KEY_NONE;
+
+  return tk->key;
 }
 
 token_t *cmd_verify(KEY_ARGS)
 {
   int i;
   token_t *first = tk;
-  cmd_t *cmd = tree_find(lia->cmdtree, hash(tk->text));
+  cmd_t *cmd = map_find(&lia->cmds, tk->hashname, tk->text);
 
   if ( !cmd ) {
     lia_error(file->filename, tk->line, tk->column,
@@ -69,7 +95,7 @@ token_t *cmd_verify(KEY_ARGS)
 
     switch (cmd->args[i].type) {
     case 'r':
-      if ( !isreg(tk) ) {
+      if (tk->type != TK_REGISTER) {
         lia_error(file->filename, tk->line, tk->column,
           "Command '%s' expects a register at operand %d.", first->text, i+1);
         return NULL;
@@ -84,7 +110,7 @@ token_t *cmd_verify(KEY_ARGS)
       }
       break;
     case 'p':
-      if ( tk->type != TK_ID || isreg(tk) ) {
+      if (tk->type != TK_ID) {
         lia_error(file->filename, tk->line, tk->column,
           "Command '%s' expects a procedure name at operand %d.",
           first->text, i+1);
@@ -116,7 +142,7 @@ token_t *cmd_verify(KEY_ARGS)
     return NULL;
   }
 
-  inst_t *inst = inst_add(lia->instlist, INST_CMD);
+  inst_t *inst = inst_add(&lia->instlist, INST_CMD);
   inst->child = first;
   inst->file = file;
   tk->next = NULL;
@@ -129,14 +155,14 @@ static token_t *key_op1reg(KEY_ARGS, inst_type_t type)
 {
   tk = tk->next;
 
-  if ( !isreg(tk) ) {
+  if (tk->type != TK_REGISTER) {
     lia_error(file->filename, tk->line, tk->column,
       "Expected a register name, instead have `%s'", tk->text);
     return NULL;
   }
 
   token_t *next = tk->next;
-  inst_t *inst = inst_add(lia->instlist, type);
+  inst_t *inst = inst_add(&lia->instlist, type);
   inst->child = tk->last;
   inst->file = file;
   tk->next = NULL;
@@ -149,14 +175,15 @@ static token_t *key_op1ri(KEY_ARGS,  inst_type_t type)
 {
   tk = tk->next;
 
-  if ( !isreg(tk) && tk->type != TK_IMMEDIATE && tk->type != TK_CHAR ) {
+  if (tk->type != TK_REGISTER && tk->type != TK_IMMEDIATE &&
+      tk->type != TK_CHAR) {
     lia_error(file->filename, tk->line, tk->column,
       "Expected a register name or immediate value, instead have `%s'", tk->text);
     return NULL;
   }
 
   token_t *next = tk->next;
-  inst_t *inst = inst_add(lia->instlist, type);
+  inst_t *inst = inst_add(&lia->instlist, type);
   inst->child = tk->last;
   inst->file = file;
   tk->next = NULL;
@@ -169,14 +196,14 @@ static token_t *key_op1id(KEY_ARGS,  inst_type_t type)
 {
   tk = tk->next;
 
-  if ( tk->type != TK_ID || isreg(tk) ) {
+  if (tk->type != TK_ID) {
     lia_error(file->filename, tk->line, tk->column,
       "Expected a procedure name, instead have `%s'", tk->text);
     return NULL;
   }
 
   token_t *next = tk->next;
-  inst_t *inst = inst_add(lia->instlist, type);
+  inst_t *inst = inst_add(&lia->instlist, type);
   inst->child = tk->last;
   inst->file = file;
   tk->next = NULL;
@@ -188,7 +215,7 @@ static token_t *key_op1id(KEY_ARGS,  inst_type_t type)
 static token_t *key_opnone(KEY_ARGS,  inst_type_t type)
 {
   token_t *next = tk->next;
-  inst_t *inst = inst_add(lia->instlist, type);
+  inst_t *inst = inst_add(&lia->instlist, type);
   inst->child = tk;
   inst->file = file;
   tk->next = NULL;
@@ -206,7 +233,7 @@ static token_t *key_op1str(KEY_ARGS, inst_type_t type)
     return NULL;
   }
   
-  inst_t *inst = inst_add(lia->instlist, type);
+  inst_t *inst = inst_add(&lia->instlist, type);
   inst->child = tk->last;
   inst->file = file;
 
@@ -235,7 +262,7 @@ token_t *key_func(KEY_ARGS)
   }
 
   token_t *next = tk->next;
-  inst_t *inst = inst_add(lia->instlist, INST_FUNC);
+  inst_t *inst = inst_add(&lia->instlist, INST_FUNC);
   inst->child = tk->last;
   inst->file = file;
   tk->next = NULL;
@@ -270,7 +297,13 @@ token_t *key_call(KEY_ARGS)
 
 token_t *key_proc(KEY_ARGS)
 {
-  return key_op1id(tk, file, lia, INST_PROC);
+  token_t *next = key_op1id(tk, file, lia, INST_PROC);
+
+  if (next)
+    lia->instlist.inst[lia->instlist.last].inline_hint = lia->inlinenext != NULL;
+
+  lia->inlinenext = NULL;
+  return next;
 }
 
 token_t *key_endproc(KEY_ARGS)
@@ -283,7 +316,8 @@ token_t *key_ret(KEY_ARGS)
   token_t *next;
   tk = tk->next;
 
-  if (tk->type == TK_IMMEDIATE || tk->type == TK_CHAR || isreg(tk) ) {
+  if (tk->type == TK_IMMEDIATE || tk->type == TK_CHAR ||
+      tk->type == TK_REGISTER) {
     next = tk->next;
     tk->next = NULL;
   } else if (tk->type != TK_SEPARATOR && tk->type != TK_EOF) {
@@ -296,7 +330,7 @@ token_t *key_ret(KEY_ARGS)
     tk->last->next = NULL;
   }
 
-  inst_t *inst = inst_add(lia->instlist, INST_RET);
+  inst_t *inst = inst_add(&lia->instlist, INST_RET);
   inst->child = tk->last;
   inst->file = file;
 
@@ -309,10 +343,10 @@ token_t *key_if(KEY_ARGS)
   token_t *next;
 
   if (tk->next->type == TK_ID) {
-    inst = inst_add(lia->instlist, INST_IF);
+    inst = inst_add(&lia->instlist, INST_IF);
     inst->child = tk;
     
-    next = calloc(1, sizeof *next);
+    next = tknew(lia);
     next->line = tk->line;
     next->type = TK_SEPARATOR;
     next->last = tk;
@@ -320,7 +354,7 @@ token_t *key_if(KEY_ARGS)
     tk->next = NULL;
   } else {
     next = tk->next;
-    inst = inst_add(lia->instlist, INST_IFBLOCK);
+    inst = inst_add(&lia->instlist, INST_IFBLOCK);
     inst->child = tk;
     tk->next = NULL;
   }
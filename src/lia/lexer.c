@@ -8,12 +8,28 @@
  * @copyright Copyright (c) 2020 Luiz Felipe
  * 
  */
+#define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#ifndef _WIN32
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
 #include "lia/lexer.h"
+#include "lia/parser.h"
 #include "lia/error.h"
-#include "lia/free.h"
+
+/** Size of each chunk read from an input that can't be mapped */
+#define SRC_CHUNK 65536
+
+/** A source code loaded in one contiguous buffer */
+typedef struct source {
+  char *data;
+  size_t size;
+  void *map;       /**< The mapping, or NULL if data was allocated */
+  size_t mapsize;
+} source_t;
 
 static int istkid(int c)
 {
@@ -25,6 +41,30 @@ static int isstrvalid(int c)
   return c >= 1 && c <= 127;
 }
 
+/**
+ * @brief Gets the register with the name.
+ * 
+ * @param name     The name, don't need to be null-terminated.
+ * @param length   Length of the name.
+ * @return reg_t   REG_NONE if it's not a register.
+ */
+static reg_t name2reg(const unsigned char *name, size_t length)
+{
+  if (length != 2)
+    return REG_NONE;
+
+  if (name[0] == 'r' && name[1] >= 'a' && name[1] <= 'l')
+    return REG_RA + (name[1] - 'a');
+
+  if (name[0] == 's' && name[1] == 's')
+    return REG_SS;
+
+  if (name[0] == 'd' && name[1] == 'p')
+    return REG_DP;
+
+  return REG_NONE;
+}
+
 /**
  * @brief Escape the character
  * 
@@ -62,48 +102,82 @@ int chresc(int c)
 /**
  * @brief Converts the text to a matched token type.
  * 
+ * The name is compared with one token type's name at most, selected
+ * by the first character.
+ * 
  * @param name           The name do convert.
- * @return token_type_t  -1 if not match.
+ * @return token_type_t  TK_INVALID if not match.
  */
 token_type_t name2tktype(char *name)
 {
-  const char *list[] = {
-    [TK_EOF] = ":EOF:",
-    [TK_ID] = "id",
-    [TK_IMMEDIATE] = "number",
-    [TK_CHAR] = "char",
-    [TK_STRING] = "str",
-    [TK_REGISTER] = "reg",
-    [TK_SEPARATOR] = ";",
-    [TK_OPENBRACKET] = "[",
-    [TK_CLOSEBRACKET] = "]",
-    [TK_OPENPARENS] = "(",
-    [TK_CLOSEPARENS] = ")",
-    [TK_COLON] = ":",
-    [TK_COMMA] = ",",
-    [TK_EQUAL] = "=",
-    [TK_PLUS] = "+",
-    [TK_MINUS] = "-",
-    [TK_ASTERISK] = "*",
-    [TK_SLASH] = "/",
-    [TK_PERCENT] = "%",
-    [TK_BKSLASH] = "\\",
-    [TK_GT] = ">",
-    [TK_LT] = "<",
-    [TK_DOLLAR] = "$",
-    [TK_AND] = "&",
-    [TK_PIPE] = "|",
-    [TK_EXCLAMATION] = "!",
-    [TK_QUESTION] = "?",
-    [TK_INVALID] = NULL
+  /* TK_EOF (zero) marks the characters that aren't a token */
+  static const token_type_t chars[128] = {
+    [';'] = TK_SEPARATOR,
+    ['['] = TK_OPENBRACKET,
+    [']'] = TK_CLOSEBRACKET,
+    ['('] = TK_OPENPARENS,
+    [')'] = TK_CLOSEPARENS,
+    [':'] = TK_COLON,
+    [','] = TK_COMMA,
+    ['='] = TK_EQUAL,
+    ['+'] = TK_PLUS,
+    ['-'] = TK_MINUS,
+    ['*'] = TK_ASTERISK,
+    ['/'] = TK_SLASH,
+    ['%'] = TK_PERCENT,
+    ['\\'] = TK_BKSLASH,
+    ['>'] = TK_GT,
+    ['<'] = TK_LT,
+    ['$'] = TK_DOLLAR,
+    ['&'] = TK_AND,
+    ['|'] = TK_PIPE,
+    ['!'] = TK_EXCLAMATION,
+    ['?'] = TK_QUESTION
   };
+  unsigned char first = name[0];
+  token_type_t type;
+  const char *typename;
 
-  for (int i = 0; list[i]; i++) {
-    if ( !strcmp(list[i], name) )
-      return i;
+  if ( first && !name[1] ) {
+    if (first >= sizeof chars / sizeof *chars || !chars[first])
+      return TK_INVALID;
+
+    return chars[first];
   }
 
-  return TK_INVALID;
+  switch (first) {
+  case ':':
+    typename = ":EOF:";
+    type = TK_EOF;
+    break;
+  case 'i':
+    typename = "id";
+    type = TK_ID;
+    break;
+  case 'n':
+    typename = "number";
+    type = TK_IMMEDIATE;
+    break;
+  case 'c':
+    typename = "char";
+    type = TK_CHAR;
+    break;
+  case 's':
+    typename = "str";
+    type = TK_STRING;
+    break;
+  case 'r':
+    typename = "reg";
+    type = TK_REGISTER;
+    break;
+  default:
+    return TK_INVALID;
+  }
+
+  if ( strcmp(name, typename) )
+    return TK_INVALID;
+
+  return type;
 }
 
 const char *tktype2name(token_type_t type)
@@ -141,34 +215,177 @@ const char *tktype2name(token_type_t type)
   return list[type];
 }
 
+/**
+ * @brief Loads all the input in one contiguous buffer.
+ * 
+ * Regular files are mapped in memory, any other input (like stdin
+ * or pipes) is read in chunks to a growing buffer.
+ * 
+ * @param src     The source to fill.
+ * @param input   The input file.
+ * @return int    0 if error, nonzero if all ok.
+ */
+static int source_load(source_t *src, FILE *input)
+{
+  size_t size;
+  char *data;
+
+  memset(src, 0, sizeof *src);
+
+#ifndef _WIN32
+  struct stat st;
+  long int offset = ftell(input);
+
+  if ( offset >= 0 && !fstat(fileno(input), &st) && S_ISREG(st.st_mode) ) {
+    if (st.st_size <= offset)
+      return 1;
+
+    src->map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+      fileno(input), 0);
+
+    if (src->map != MAP_FAILED) {
+      src->mapsize = st.st_size;
+      src->data = (char *) src->map + offset;
+      src->size = st.st_size - offset;
+      return 1;
+    }
+
+    src->map = NULL;
+  }
+#endif
+
+  for (size = SRC_CHUNK; ; size *= 2) {
+    data = realloc(src->data, size);
+    if ( !data ) {
+      free(src->data);
+      src->data = NULL;
+      return 0;
+    }
+
+    src->data = data;
+    src->size += fread(src->data + src->size, 1, size - src->size, input);
+
+    if (src->size < size)
+      break;
+  }
+
+  return !ferror(input);
+}
+
+/** Releases the buffer of the source */
+static void source_free(source_t *src)
+{
+#ifndef _WIN32
+  if (src->map) {
+    munmap(src->map, src->mapsize);
+    return;
+  }
+#endif
+
+  free(src->data);
+}
+
+/**
+ * @brief Sets the text of a token, interning it.
+ * 
+ * @param lia      The lia_t struct.
+ * @param tk       The token.
+ * @param text     The text, don't need to be null-terminated.
+ * @param length   Length of the text.
+ */
+void tktext(lia_t *lia, token_t *tk, const char *text, size_t length)
+{
+  tk->text = strtab_intern(&lia->strtab, text, length);
+  tk->hashname = ISTR(tk->text)->hash;
+}
+
+/**
+ * @brief Allocates a new zeroed token in the tokens' arena
+ * 
+ * The text of the new token is a empty string.
+ * 
+ * @param lia        The lia_t struct.
+ * @return token_t*  The new token.
+ */
+token_t *tknew(lia_t *lia)
+{
+  token_t *tk = arena_alloc(&lia->tkarena, sizeof (token_t));
+
+  tktext(lia, tk, "", 0);
+  tk->key = KEY_NONE;
+  tk->metakey = META_NONE;
+  return tk;
+}
+
+/**
+ * @brief Allocates a copy of a token in the tokens' arena
+ * 
+ * @param lia        The lia_t struct.
+ * @param src        The token to copy.
+ * @return token_t*  The new token.
+ */
+token_t *tkcopy(lia_t *lia, const token_t *src)
+{
+  token_t *tk = arena_alloc(&lia->tkarena, sizeof (token_t));
+
+  memcpy(tk, src, sizeof *tk);
+  return tk;
+}
+
 /**
  * @brief Do lexical analyze of a Lia code.
  * 
+ * The tokens are allocated in the tokens' arena of the lia_t struct.
+ * 
  * @param input      Input file to read the code.
+ * @param lia        The lia_t struct.
  * @return token_t*  If successful
  * @return NULL      If error
  */
-token_t *lia_lexer(char *filename, FILE *input)
+token_t *lia_lexer(char *filename, FILE *input, lia_t *lia)
 {
+  source_t src;
+  const unsigned char *p;
+  const unsigned char *end;
+  const unsigned char *start;
+  size_t size;
   int ch;
   int line = 1;
   int column = 0;
   token_t *new;
-  token_t *this = calloc(1, sizeof *this);
-  token_t *first = this;
+  token_t *this;
+  token_t *first;
+
+  if ( !source_load(&src, input) ) {
+    fprintf(stderr, "%s: error reading the file\n", filename);
+    return NULL;
+  }
+
+  p = (const unsigned char *) src.data;
+  end = p + src.size;
+
+/** Reads the next character, like getc() */
+#define NEXTCH() ( p < end ? *p++ : EOF )
 
+  this = tknew(lia);
+  first = this;
   this->last = NULL;
 
   while ( 1 ) {
     do {
-      ch = getc(input);
+      ch = NEXTCH();
       column++;
     } while ( isblank(ch) );
 
     if (ch == '#') {
-      do {
-        ch = getc(input);
-      } while (ch != '\n' && ch != EOF);
+      start = memchr(p, '\n', end - p);
+      if (start) {
+        p = start + 1;
+        ch = '\n';
+      } else {
+        p = end;
+        ch = EOF;
+      }
     }
 
     this->line = line;
@@ -180,7 +397,8 @@ token_t *lia_lexer(char *filename, FILE *input)
       this->next = NULL;
       this->line = line;
       this->column = column;
-      strcpy(this->text, ":EOF:");
+      tktext(lia, this, ":EOF:", 5);
+      source_free(&src);
       return first;
 
     case '\n':
@@ -189,267 +407,237 @@ token_t *lia_lexer(char *filename, FILE *input)
       // No break here!
     case ';':
       this->type = TK_SEPARATOR;
-      strcpy(this->text, ":SEPARATOR:");
+      tktext(lia, this, ":SEPARATOR:", 11);
       break;
-
     case '[':
       this->type = TK_OPENBRACKET;
-      strcpy(this->text, "[");
       break;
 
     case ']':
       this->type = TK_CLOSEBRACKET;
-      strcpy(this->text, "]");
       break;
     
     case '(':
       this->type = TK_OPENPARENS;
-      strcpy(this->text, "(");
       break;
     
     case ')':
       this->type = TK_CLOSEPARENS;
-      strcpy(this->text, ")");
       break;
 
     case '=':
       this->type = TK_EQUAL;
-      strcpy(this->text, "=");
       break;
 
     case '+':
       this->type = TK_PLUS;
-      strcpy(this->text, "+");
       break;
 
     case '-':
       this->type = TK_MINUS;
-      strcpy(this->text, "-");
       break;
     
     case '*':
       this->type = TK_ASTERISK;
-      strcpy(this->text, "*");
       break;
     
     case '/':
       this->type = TK_SLASH;
-      strcpy(this->text, "/");
       break;
     case '%':
       this->type = TK_PERCENT;
-      strcpy(this->text, "%");
       break;
     
     case '\\':
       this->type = TK_BKSLASH;
-      strcpy(this->text, "\\");
       break;
     
     case '>':
       this->type = TK_GT;
-      strcpy(this->text, ">");
       break;
     
     case '<':
       this->type = TK_LT;
-      strcpy(this->text, "<");
       break;
     
     case '$':
       this->type = TK_DOLLAR;
-      strcpy(this->text, "$");
       break;
     
     case '&':
       this->type = TK_AND;
-      strcpy(this->text, "&");
       break;
     
     case '|':
       this->type = TK_PIPE;
-      strcpy(this->text, "|");
       break;
     
     case '!':
       this->type = TK_EXCLAMATION;
-      strcpy(this->text, "!");
       break;
     
     case '?':
       this->type = TK_QUESTION;
-      strcpy(this->text, "?");
       break;
 
     case ':':
       this->type = TK_COLON;
-      strcpy(this->text, ":");
       break;
 
     case ',':
       this->type = TK_COMMA;
-      strcpy(this->text, ",");
       break;
 
     case '\'':
       this->type = TK_CHAR;
+      start = p;
       
-      ch = getc(input);
+      ch = NEXTCH();
 
       if (ch == '\\') {
-        ch = getc(input);
+        ch = NEXTCH();
         int esc = chresc(ch);
         
         if (esc < 0) {
           lia_error(filename, line, column, "'\\%c' is not a valid escape character", ch);
-          tkfree(first);
-          return NULL;
+          goto error;
         }
 
         this->value = esc;
-        this->text[0] = '\\';
-        this->text[1] = ch;
         column += 2;
       } else if ( !isstrvalid(ch) ) {
         lia_error(filename, line, column, "'%c' is not a valid character", ch);
-        tkfree(first);
-        return NULL;
+        goto error;
       } else {
         this->value = ch;
-        this->text[0] = ch;
         column++;
       }
 
-      if (getc(input) != '\'') {
+      if (NEXTCH() != '\'') {
         lia_error(filename, line, column, "%s",
           "Literal character should have one byte of length");
-        tkfree(first);
-        return NULL;
+        goto error;
       }
 
+      tktext(lia, this, (const char *) start, p - start - 1);
       column++;
       break;
 
     case '"':
       this->type = TK_STRING;
+      start = p;
       
-      for (int i = 0; (ch = getc(input)) != '"'; i++) {
+      for (int i = 0; (ch = NEXTCH()) != '"'; i++) {
         column++;
 
-        if (i >= TKMAX) {
+        if (i >= TKMAX - 1) {
           lia_error(filename, this->line, this->column,
             "Maximum size of a string is %d characters", TKMAX-1);
-          tkfree(first);
-          return NULL;
+          goto error;
         }
 
         if (ch == '\r' || ch == '\n') {
           lia_error(filename, line, column,
             "%s", "Unexpected break of line inside a string");
-          tkfree(first);
-          return NULL;
+          goto error;
         }
 
         if ( !isstrvalid(ch) ) {
           lia_error(filename, line, column,
             "Invalid character 0x%02x ('%c') inside a string", ch, ch);
-          tkfree(first);
-          return NULL;
+          goto error;
         }
-
-        this->text[i] = ch;
       }
 
+      tktext(lia, this, (const char *) start, p - start - 1);
       column++;
       break;
 
     default:
+      start = p - 1;
+
       if ( isdigit(ch) ) {
         int (*filter)(int) = isdigit;
         this->type = TK_IMMEDIATE;
-        this->text[0] = ch;
-
-        ch = getc(input);
         column++;
 
-        if ( isalnum(ch) ) {
-          if ( ch == 'x' || ch == 'X' ) {
+        if ( p < end && isalnum(*p) ) {
+          if ( *p == 'x' || *p == 'X' ) {
             filter = isxdigit;
           }
 
-          this->text[1] = ch;
-
-          for (int i = 2;; i++) {
-            if (i >= TKMAX) {
-              lia_error(filename, this->line, this->column,
-                "Maximum size of a token is %d characters", TKMAX-1);
-              tkfree(first);
-              return NULL;
-            }
-            
-            ch = getc(input);
-
-            if ( !filter(ch) )
-              break;
-
-            this->text[i] = ch;
+          for (p++; p < end && filter(*p); p++)
             column++;
-          }
         }
 
-        char *end;
+        size = p - start;
+        if (size >= TKMAX) {
+          lia_error(filename, this->line, this->column,
+            "Maximum size of a token is %d characters", TKMAX-1);
+          goto error;
+        }
+
+        tktext(lia, this, (const char *) start, size);
+
+        char *endnum;
 
-        int i = strtoul(this->text, &end, 0);
+        int i = strtoul(this->text, &endnum, 0);
 
-        if ( *end ) {
+        if ( *endnum ) {
           lia_error(filename, this->line, this->column,
             "Invalid literal number '%s'", this->text);
-          tkfree(first);
-          return NULL;
+          goto error;
         }
 
         if (i < 0 || i > 255) {
           lia_error(filename, this->line, this->column,
             "Literal number should be between 0 and 255, instead: %d", i);
-          tkfree(first);
-          return NULL;
+          goto error;
         }
 
         this->value = i;
-        ungetc(ch, input);
       } else if ( istkid(ch) ) {
         this->type = TK_ID;
-        this->text[0] = ch;
-
-        for (int i = 1;; i++) {
-          if (i >= TKMAX) {
-            lia_error(filename, this->line, this->column,
-              "Maximum size of a token is %d characters", TKMAX-1);
-            tkfree(first);
-            return NULL;
-          }
-
-          ch = getc(input);
 
-          if ( !istkid(ch) )
-            break;
+        while ( p < end && istkid(*p) )
+          p++;
 
-          this->text[i] = ch;
-          column++;
+        size = p - start;
+        if (size >= TKMAX) {
+          lia_error(filename, this->line, this->column,
+            "Maximum size of a token is %d characters", TKMAX-1);
+          goto error;
         }
 
-        ungetc(ch, input);
+        tktext(lia, this, (const char *) start, size);
+        column += size - 1;
+
+        reg_t reg = name2reg(start, size);
+        if (reg != REG_NONE) {
+          this->type = TK_REGISTER;
+          this->value = reg;
+        } else {
+          this->key = name2key((const char *) start, size);
+          this->metakey = name2metakey((const char *) start, size);
+        }
       } else {
         lia_error(filename, line, column, "Unexpected character '%c'", ch);
-        tkfree(first);
-        return NULL;
+        goto error;
       }
     }
 
+    if (this->type >= TK_OPENBRACKET && this->type <= TK_QUESTION)
+      tktext(lia, this, (const char *) p - 1, 1);
     
-    new = calloc(1, sizeof *new);
+    new = tknew(lia);
     new->last = this;
     this->next = new;
     this = new;
   }
+
+#undef NEXTCH
+
+error:
+  source_free(&src);
+  return NULL;
 }
@@ -0,0 +1,175 @@
+/**
+ * @file    memo.c
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Cache of the macro's expansions
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "lia/memo.h"
+#include "strtab.h"
+
+/**
+ * @brief Calculates the hash of a call to a macro's variant.
+ * 
+ * The text of the arguments are interned, so the hash of its strings is
+ * reused.
+ * 
+ * @param variant            The variant.
+ * @param args               The tokens of the arguments.
+ * @param argc               The number of arguments.
+ * @return unsigned long int The hash.
+ */
+unsigned long int memo_hash(macro_var_t *variant, token_t **args, size_t argc)
+{
+  unsigned long int hash = (uintptr_t) variant;
+
+  for (size_t i = 0; i < argc; i++)
+    hash = hash * 31 + ISTR(args[i]->text)->hash;
+
+  return hash;
+}
+
+/**
+ * @brief Finds a cached expansion of a call.
+ * 
+ * The entries cached before the current generation are ignored.
+ * 
+ * @param memo           The cache.
+ * @param hash           The hash of the call, from memo_hash().
+ * @param generation     The current generation.
+ * @param variant        The variant.
+ * @param args           The tokens of the arguments.
+ * @param argc           The number of arguments.
+ * @return macro_memo_t* The entry, or NULL if not found.
+ */
+macro_memo_t *memo_find(memo_t *memo, unsigned long int hash,
+  unsigned long int generation, macro_var_t *variant, token_t **args,
+  size_t argc)
+{
+  macro_memo_t *this = NULL;
+  size_t i;
+
+  if (memo->size)
+    this = memo->buckets[hash & (memo->size - 1)];
+
+  for (; this; this = this->next) {
+    if (this->hash != hash || this->variant != variant
+        || this->generation != generation || this->argc != argc)
+      continue;
+
+    for (i = 0; i < argc; i++) {
+      if (this->args[i] != args[i]->text)
+        break;
+    }
+
+    if (i == argc) {
+      memo->hits++;
+      return this;
+    }
+  }
+
+  memo->misses++;
+  return NULL;
+}
+
+/**
+ * @brief Allocates a new entry, without inserting it at the cache.
+ * 
+ * The instructions of the entry must be set before memo_insert(), or
+ * the entry discarded with free().
+ * 
+ * @param hash           The hash of the call, from memo_hash().
+ * @param generation     The current generation.
+ * @param variant        The variant.
+ * @param args           The tokens of the arguments.
+ * @param argc           The number of arguments.
+ * @return macro_memo_t* The new entry.
+ */
+macro_memo_t *memo_new(unsigned long int hash, unsigned long int generation,
+  macro_var_t *variant, token_t **args, size_t argc)
+{
+  macro_memo_t *entry = malloc(sizeof *entry + argc * sizeof (char *));
+  if ( !entry ) {
+    fputs("Memo: Out of memory\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  entry->next = NULL;
+  entry->hash = hash;
+  entry->generation = generation;
+  entry->variant = variant;
+  entry->args = (char **) (entry + 1);
+  entry->argc = argc;
+  entry->start = 0;
+  entry->end = 0;
+
+  for (size_t i = 0; i < argc; i++)
+    entry->args[i] = args[i]->text;
+
+  return entry;
+}
+
+/**
+ * @brief Inserts a entry at the cache.
+ * 
+ * @param memo   The cache.
+ * @param entry  The entry from memo_new().
+ */
+void memo_insert(memo_t *memo, macro_memo_t *entry)
+{
+  macro_memo_t **buckets;
+  macro_memo_t *next;
+  size_t size;
+
+  if (memo->count >= memo->size) {
+    size = memo->size ? memo->size * 2 : MEMO_SIZE;
+    buckets = calloc(size, sizeof *buckets);
+    if ( !buckets ) {
+      fputs("Memo: Out of memory\n", stderr);
+      exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < memo->size; i++) {
+      for (macro_memo_t *this = memo->buckets[i]; this; this = next) {
+        next = this->next;
+        this->next = buckets[this->hash & (size - 1)];
+        buckets[this->hash & (size - 1)] = this;
+      }
+    }
+
+    free(memo->buckets);
+    memo->buckets = buckets;
+    memo->size = size;
+  }
+
+  entry->next = memo->buckets[entry->hash & (memo->size - 1)];
+  memo->buckets[entry->hash & (memo->size - 1)] = entry;
+  memo->count++;
+}
+
+/**
+ * @brief Free all the entries of the cache.
+ * 
+ * @param memo  The cache.
+ */
+void memo_free(memo_t *memo)
+{
+  macro_memo_t *next;
+
+  for (size_t i = 0; i < memo->size; i++) {
+    for (macro_memo_t *this = memo->buckets[i]; this; this = next) {
+      next = this->next;
+      free(this);
+    }
+  }
+
+  free(memo->buckets);
+  memo->buckets = NULL;
+  memo->size = 0;
+  memo->count = 0;
+}
@@ -17,11 +17,13 @@ int action(KEY_ARGS)
 {
   static const char *list[] = {
     "stop",
+    "inline",
     NULL
   };
 
   static int (*dolist[])(KEY_ARGS) = {
-    action_stop
+    action_stop,
+    action_inline
   };
 
   for (int i = 0; list[i]; i++) {
@@ -40,6 +42,13 @@ int action_stop(KEY_ARGS)
   return 1;
 }
 
+/** Hints the optimizer to inline the next procedure declared */
+int action_inline(KEY_ARGS)
+{
+  lia->inlinenext = tk;
+  return 1;
+}
+
 
 token_t *meta_action(KEY_ARGS)
 {
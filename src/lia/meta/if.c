@@ -12,16 +12,16 @@
 #include <stdarg.h>
 #include <string.h>
 #include "lia/lia.h"
-#include "tree.h"
+#include "map.h"
 
 /** Returns the macro's value */
-static token_t *getmacro(macro_t *tree, char *name)
+static token_t *getmacro(map_t *macros, token_t *tk)
 {
-  macro_t *macro = tree_find(tree, hash(name));
+  macro_t *macro = map_find(macros, tk->hashname, tk->text);
   if ( !macro )
     return NULL;
   
-  macro_var_t *variant = tree_find(macro->variants, INITIAL_HASH);
+  macro_var_t *variant = map_find(&macro->variants, INITIAL_HASH, "");
   if ( !variant )
     return NULL;
   
@@ -69,7 +69,7 @@ static bool mif_expr(lia_t *lia, imp_t *file, token_t **tk)
 
   if ( !isany(*tk, 2, TK_EQUAL, TK_EXCLAMATION) ) {
     if (v1->type == TK_ID)
-      return (getmacro(lia->macrotree, v1->text) != NULL) != isnot;
+      return (getmacro(&lia->macros, v1) != NULL) != isnot;
     
     return (v1->type == TK_STRING || v1->value) != isnot;
   }
@@ -105,9 +105,9 @@ static bool mif_expr(lia_t *lia, imp_t *file, token_t **tk)
   *tk = metanext(*tk);
 
   if (v1->type == TK_ID)
-    v1 = getmacro(lia->macrotree, v1->text);
+    v1 = getmacro(&lia->macros, v1);
   if (v2->type == TK_ID)
-    v2 = getmacro(lia->macrotree, v2->text);
+    v2 = getmacro(&lia->macros, v2);
   
   if ( !v1 || !v2 || v1->type != v2->type )
     return false;
@@ -12,19 +12,18 @@
 #include <stdbool.h>
 #include <string.h>
 #include "lia/lia.h"
-#include "tree.h"
+#include "map.h"
 
 /**
  * @brief Prints the sequence of tokens of a variant.
  * 
- * This function can be used with tree_map().
+ * This function can be used with map_map().
  * 
  * @param variant  The variant of a macro.
  */
-void macro_seq_print(void *tree_node)
+void macro_seq_print(void *variant)
 {
-  macro_var_t *variant = tree_node;
-  mtk_t *tkseq = variant->tkseq;
+  mtk_t *tkseq = ((macro_var_t *) variant)->tkseq;
 
   putc('(', stderr);
   for (; tkseq; tkseq = tkseq->next) {
@@ -56,6 +55,91 @@ void macro_seq_print(void *tree_node)
   fputs(" )\n", stderr);
 }
 
+/**
+ * @brief Prints the sequence of tokens of all the variants below a node.
+ * 
+ * @param node  A node of the trie of variants.
+ */
+void macro_candidates(macro_node_t *node)
+{
+  if (node->variant)
+    macro_seq_print(node->variant);
+
+  for (int i = 0; i < TK_INVALID; i++) {
+    if (node->child[i])
+      macro_candidates(node->child[i]);
+  }
+}
+
+/**
+ * @brief Indexes a variant at the trie of its macro.
+ * 
+ * @param lia      The lia_t struct.
+ * @param macro    The macro.
+ * @param variant  The variant to add.
+ */
+void macro_trie_add(lia_t *lia, macro_t *macro, macro_var_t *variant)
+{
+  macro_node_t **node = &macro->trie;
+  mtk_t *this = variant->tkseq;
+
+  for (;;) {
+    if ( !*node )
+      *node = arena_alloc(&lia->tkarena, sizeof **node);
+
+    if ( !this )
+      break;
+
+    node = &(*node)->child[this->type];
+    this = this->next;
+  }
+
+  (*node)->variant = variant;
+}
+
+/**
+ * @brief Compiles the body of a variant to a template.
+ * 
+ * Each token of the body that is the name of an argument is resolved to
+ * the argument's index at the sequence of tokens, so the expansion only
+ * needs to fill the slots.
+ * 
+ * @param lia      The lia_t struct.
+ * @param variant  The variant of a macro.
+ */
+void macro_template(lia_t *lia, macro_var_t *variant)
+{
+  unsigned int n = 0;
+  token_t *this;
+  mtk_t *arg;
+  int slot;
+
+  for (this = variant->body; this; this = this->next)
+    n++;
+
+  variant->pieces = arena_alloc(&lia->tkarena, n * sizeof *variant->pieces);
+  variant->npieces = n;
+
+  n = 0;
+  for (this = variant->body; this; this = this->next) {
+    slot = MACRO_LITERAL;
+    if (this->type == TK_ID) {
+      /* Both the names are interned, so comparing the pointers is enough */
+      arg = variant->tkseq;
+      for (int i = 0; arg; arg = arg->next, i++) {
+        if (arg->name == this->text) {
+          slot = i;
+          break;
+        }
+      }
+    }
+
+    variant->pieces[n].slot = slot;
+    variant->pieces[n].tk = this;
+    n++;
+  }
+}
+
 
 token_t *meta_macro(KEY_ARGS)
 {
@@ -63,7 +147,8 @@ token_t *meta_macro(KEY_ARGS)
   macro_t *macro;
   token_t *first;
   mtk_t *macro_tkseq = NULL;
-  unsigned long int tkseq_hash = INITIAL_HASH;
+  char signature[MACRO_ARGMAX + 1];
+  size_t argc = 0;
 
   tk = metanext(tk);
   first = tk;
@@ -74,18 +159,21 @@ token_t *meta_macro(KEY_ARGS)
     return NULL;
   }
 
-  macro = tree_find(lia->macrotree, hash(tk->text));
-  if ( !macro ) {
-    macro = tree_insert(lia->macrotree, sizeof *macro, hash(tk->text));
-    macro->name = tk->text;
-    macro->variants = calloc(1, sizeof (macro_var_t));
-  }
+  macro = map_find(&lia->macros, tk->hashname, tk->text);
+  if ( !macro )
+    macro = map_insert(&lia->macros, sizeof *macro, tk->hashname, tk->text);
 
   tk = metanext(tk);
   if (tk->type == TK_OPENPARENS) {
     tk = metanext(tk);
 
     for (; tk->type != TK_CLOSEPARENS; tk = tk->next) {
+      if (argc >= MACRO_ARGMAX) {
+        lia_error(file->filename, tk->line, tk->column,
+          "Maximum of %d tokens at the macro's arguments.", MACRO_ARGMAX);
+        return NULL;
+      }
+
       if (tk->type == TK_ID) {
         switch ( tkseq(tk, 3, TK_ID, TK_COLON, TK_ID) ) {
         case -1:
@@ -142,7 +230,7 @@ token_t *meta_macro(KEY_ARGS)
         return NULL;
       }
 
-      hashint(&tkseq_hash, type);
+      signature[argc++] = TKSIG(type);
     }
     
     tk = metanext(tk);
@@ -161,14 +249,16 @@ token_t *meta_macro(KEY_ARGS)
     return NULL;
   }
 
-  if ( tree_find(macro->variants, tkseq_hash) ) {
+  char *name = strtab_intern(&lia->strtab, signature, argc);
+  macro_var_t *variant = map_insert(&macro->variants, sizeof *variant,
+    ISTR(name)->hash, name);
+
+  if ( !variant ) {
     lia_error(file->filename, first->line, first->column,
       "Redeclaration of macro '%s' with the same sequence of tokens.", macro->name);
     return NULL;
   }
 
-  macro_var_t *variant = tree_insert(macro->variants, sizeof *variant, tkseq_hash);
-
   variant->tkseq = macro_tkseq;
   variant->body = tk;
 
@@ -186,168 +276,358 @@ token_t *meta_macro(KEY_ARGS)
   }
 
   tk->last->last->next = NULL;
+  macro_template(lia, variant);
+  macro_trie_add(lia, macro, variant);
+  lia->generation++;
   return tk->last;
 }
 
 /**
- * @brief Expands the body of a macro.
+ * @brief Pushes a frame to the work stack if the token is a macro's call.
  * 
- * @param tk         The token of the macro call.
- * @param file       The file where this token is.
- * @param lia        The lia_t struct.
- * @return token_t*  Last token before the macro's content.
+ * @param tk     The token of the macro call.
+ * @param file   The file where this token is.
+ * @param lia    The lia_t struct.
+ * @return bool  true if the frame was pushed.
  */
-token_t *macro_expand(token_t *tk, imp_t *file, lia_t *lia)
+static bool macro_push(token_t *tk, imp_t *file, lia_t *lia)
 {
-  bool expr = false;
+  size_t maxdepth = lia->maxdepth ? lia->maxdepth : MACRO_MAXDEPTH;
+  macro_frame_t *frame;
   macro_t *macro;
-  macro_var_t *variant;
-  macro_arg_t *argtree;
-  macro_arg_t *arg = NULL;
-  unsigned long int tkseq_hash = INITIAL_HASH;
   token_t *first = tk;
-  token_t *next;
-  token_t *firstseq = NULL;
+  bool expr;
 
   if (tk->type == TK_OPENPARENS) {
-    macro = tree_find(lia->macrotree, hash(MACRO_EXPR));
+    macro = map_find(&lia->macros, hash(MACRO_EXPR), MACRO_EXPR);
     tk = tk->last;
     expr = true;
   } else {
-    macro = tree_find(lia->macrotree, hash(tk->text));
+    macro = map_find(&lia->macros, tk->hashname, tk->text);
     expr = !strcmp(tk->text, MACRO_EXPR);
   }
 
   if ( !macro )
-    return NULL;
+    return false;
 
-  if (tk->next->type == TK_OPENPARENS) {
-    firstseq = tk->next;
-    tk = tk->next->next;
-    for (; tk->type != TK_CLOSEPARENS; tk = tk->next) {
-      if (tk->type == TK_ID || tk->type == TK_OPENPARENS) {
-        next = macro_expand(tk, file, lia);
-        if (next) {
-          tk->last->next = next->next;
-          tk = next->next;
-          
-        }
-      }
+  if (lia->mdepth >= maxdepth) {
+    lia_error(file->filename, first->line, first->column,
+      "The expansion of the macro '%s' exceeds the maximum depth of %zu.",
+      macro->name, maxdepth);
+    file->stop = true;
+    lia->errcount++;
+    return false;
+  }
+
+  if (lia->mdepth >= lia->msize) {
+    size_t size = lia->msize ? lia->msize * 2 : MACRO_STACKSIZE;
+
+    frame = realloc(lia->mstack, size * sizeof *frame);
+    if ( !frame ) {
+      lia_error(file->filename, first->line, first->column,
+        "%s", "Out of memory to expand the macro.");
+      file->stop = true;
+      lia->errcount++;
+      return false;
+    }
+
+    lia->mstack = frame;
+    lia->msize = size;
+  }
 
-      if ( isreg(tk) )
-        hashint(&tkseq_hash, TK_REGISTER);
+  frame = &lia->mstack[lia->mdepth++];
+  frame->first = first;
+  frame->tk = tk;
+  frame->expr = expr;
+  frame->macro = macro;
+  frame->node = macro->trie;
+  frame->argc = 0;
+  frame->resumed = false;
+
+  if (frame->node && tk->next->type == TK_OPENPARENS)
+    frame->cursor = tk->next->next;
+  else
+    frame->cursor = NULL;
+
+  return true;
+}
+
+/**
+ * @brief Adds again the instructions of a cached expansion.
+ * 
+ * The tokens of the instructions are copied with the position of the call,
+ * so the errors are reported where the expansion is used.
+ * 
+ * @param lia    The lia_t struct.
+ * @param memo   The cached expansion.
+ * @param first  The first token of the call.
+ * @param file   The file where the call is.
+ */
+static void macro_replay(lia_t *lia, macro_memo_t *memo, token_t *first,
+  imp_t *file)
+{
+  token_t *last;
+  token_t *new;
+  inst_t *added;
+  inst_t inst;
+
+  for (size_t i = memo->start; i < memo->end; i++) {
+    inst = lia->instlist.inst[i];
+    added = inst_add(&lia->instlist, inst.type);
+    added->file = file;
+    last = NULL;
+
+    for (token_t *tk = inst.child; tk; tk = tk->next) {
+      new = tkcopy(lia, tk);
+      new->line = first->line;
+      new->column = first->column;
+      new->last = last;
+      new->next = NULL;
+
+      if (last)
+        last->next = new;
       else
-        hashint(&tkseq_hash, tk->type);
+        added->child = new;
+      last = new;
     }
   }
+}
 
-  variant = tree_find(macro->variants, tkseq_hash);
-  if ( !variant ) {
+/**
+ * @brief Replaces a `expr' call by its lvalue register.
+ * 
+ * @param lia        The lia_t struct.
+ * @param first      The first token of the call.
+ * @param tk         The last token of the call.
+ * @return token_t*  Last token before the lvalue.
+ */
+static token_t *macro_lvalue(lia_t *lia, token_t *first, token_t *tk)
+{
+  token_t *this = tknew(lia);
+
+  this->type = TK_REGISTER;
+  this->value = EXPR_LVALUE_REG;
+  this->line = first->line;
+  this->column = first->column;
+  tktext(lia, this, EXPR_LVALUE, strlen(EXPR_LVALUE));
+
+  first->last->next = this;
+  this->last = first->last;
+  this->next = tk->next;
+  tk->next->last = this;
+  return first->last;
+}
+
+/**
+ * @brief Replaces a macro call, with all its arguments scanned, by the body
+ * of the matched variant.
+ * 
+ * The expansion of a `expr' is parsed here, which can push new frames
+ * to the work stack. So the frame can't be used after that.
+ * 
+ * @param frame      The frame of the call.
+ * @param file       The file where the call is.
+ * @param lia        The lia_t struct.
+ * @return token_t*  Last token before the macro's content.
+ */
+static token_t *macro_apply(macro_frame_t *frame, imp_t *file, lia_t *lia)
+{
+  size_t maxgrowth = lia->maxgrowth ? lia->maxgrowth : MACRO_MAXGROWTH;
+  macro_node_t *node = frame->node;
+  token_t *first = frame->first;
+  token_t *tk = frame->cursor ? frame->cursor : frame->tk;
+  macro_var_t *variant;
+  macro_memo_t *memo = NULL;
+  unsigned long int hash;
+
+  if ( !node || !node->variant ) {
     lia_error(file->filename, first->line, first->column,
       "Macro '%s' don't have a variant with this sequence. Instead try:",
-      macro->name);
-    tree_map(macro->variants, macro_seq_print);
+      frame->macro->name);
+    if (node)
+      macro_candidates(node);
     return NULL;
   }
 
-  argtree = calloc(1, sizeof *argtree);
-
-  if (firstseq) {
-    firstseq = firstseq->next;
-    for (mtk_t *this = variant->tkseq; this; this = this->next) {
-      switch (this->type) {
-      case TK_REGISTER:
-        if ( !isreg(firstseq) ) {
-          lia_error(file->filename, firstseq->line, firstseq->column,
-            "Expected a register name, instead have: `%s'", firstseq->text);
-          return NULL;
-        }
-        break;
-      default:
-        if (this->type != firstseq->type) {
-          lia_error(file->filename, firstseq->line, firstseq->column,
-            "Expected `%s' token, instead have: `%s'", tktype2name(this->type),
-            firstseq->text);
-          return NULL;
-        }
-      }
-
-      if (this->name) {
-        arg = tree_insert(argtree, sizeof *arg, hash(this->name));
-        
-        arg->name = this->name;
-        arg->type = firstseq->type;
-        arg->body = firstseq;
-      }
+  variant = node->variant;
 
-      firstseq = firstseq->next;
+  if (frame->expr) {
+    hash = memo_hash(variant, frame->args, frame->argc);
+    memo = memo_find(&lia->memo, hash, lia->generation, variant,
+      frame->args, frame->argc);
+    if (memo) {
+      macro_replay(lia, memo, first, file);
+      return macro_lvalue(lia, first, tk);
     }
-  }
-
-  token_t *new;
-  token_t *this = variant->body;
-  token_t *body = malloc(sizeof *body);
-  first->last->next = body;
 
-  if (this->type == TK_ID)
-    arg = tree_find(argtree, hash(this->text));
-  else
-    arg = NULL;
-  
-  if (arg) {
-    memcpy(body, arg->body, sizeof *body);
-  } else {
-    memcpy(body, variant->body, sizeof *body);
-    body->line = first->line;
-    body->column = first->column;
+    memo = memo_new(hash, lia->generation, variant, frame->args, frame->argc);
   }
 
-  body->last = first->last;
+  lia->growth += variant->npieces;
+  if (lia->growth > maxgrowth) {
+    lia_error(file->filename, first->line, first->column,
+      "The expansion of the macro '%s' exceeds the budget of %zu tokens.",
+      frame->macro->name, maxgrowth);
+    file->stop = true;
+    lia->errcount++;
+    free(memo);
+    return NULL;
+  }
 
-  for (this = this->next; this; this = this->next) {
-    new = malloc(sizeof *new);
-    body->next = new;
+  /*
+   * The tokens of the arguments are moved to the expansion at its first use,
+   * only the repeated arguments and the literal tokens (that receives the
+   * position of the call) are copied.
+   */
+  bool moved[MACRO_ARGMAX] = {false};
+  token_t *this;
+  token_t *new;
+  token_t *body = first->last;
+  macro_piece_t *piece = variant->pieces;
 
-    arg = NULL;
-    if (this->type == TK_ID)
-      arg = tree_find(argtree, hash(this->text));
-    
-    if (arg) {
-      memcpy(new, arg->body, sizeof *new);
-    } else {
-      memcpy(new, this, sizeof *new);
+  for (unsigned int i = 0; i < variant->npieces; i++, piece++) {
+    if (piece->slot == MACRO_LITERAL) {
+      new = tkcopy(lia, piece->tk);
       new->line = first->line;
       new->column = first->column;
+    } else if ( !moved[piece->slot] ) {
+      new = frame->args[piece->slot];
+      moved[piece->slot] = true;
+    } else {
+      new = tkcopy(lia, frame->args[piece->slot]);
     }
 
     new->last = body;
+    body->next = new;
     body = new;
-    if ( !this->next )
-      break;
   }
 
-  tree_free(argtree);
+  body->next = NULL;
 
-  if (expr) {
-    this = first->last->next;
-    while (this && this->type != TK_EOF && !file->stop) {
-      this = inst_parser(lia, file, this);
-    }
+  if ( !frame->expr ) {
+    body->next = tk->next;
+    tk->next->last = body;
+    return first->last;
+  }
 
-    this = calloc(1, sizeof (token_t));
-    this->type = TK_ID;
+  /* The last instruction of a single-line body needs a separator */
+  if (body->type != TK_SEPARATOR) {
+    this = tknew(lia);
+    this->type = TK_SEPARATOR;
     this->line = first->line;
     this->column = first->column;
-    strcpy(this->text, EXPR_LVALUE);
+    this->last = body;
+    body->next = this;
+  }
+
+  /* The body is parsed recursively, so the nesting is limited before it */
+  if (lia->mnest >= MACRO_MAXNEST) {
+    lia_error(file->filename, first->line, first->column,
+      "The expression exceeds the maximum nesting of %d.", MACRO_MAXNEST);
+    file->stop = true;
+    lia->errcount++;
+    free(memo);
+    return NULL;
+  }
+
+  /*
+   * The parsing only is cached if it just added instructions, without
+   * errors or any declaration that could change the result.
+   */
+  size_t start = lia->instlist.count;
+  unsigned int errcount = lia->errcount;
+  unsigned long int generation = lia->generation;
+
+  this = first->last->next;
+  lia->mnest++;
+  while (this && this->type != TK_EOF && !file->stop) {
+    this = inst_parser(lia, file, this);
+  }
+  lia->mnest--;
 
-    first->last->next = this;
-    this->last = first->last;
-    this->next = tk->next;
-    tk->next->last = this;
+  if (lia->errcount == errcount && lia->generation == generation
+      && !file->stop) {
+    memo->start = start;
+    memo->end = lia->instlist.count;
+    memo_insert(&lia->memo, memo);
   } else {
-    body->next = tk->next;
-    tk->next->last = body;
+    free(memo);
   }
 
-  return first->last;
+  return macro_lvalue(lia, first, tk);
+}
+
+/**
+ * @brief Expands the body of a macro.
+ * 
+ * The nested macro calls at the arguments are expanded first, using a
+ * work stack instead of recursion. The depth of the stack and the number
+ * of expanded tokens are limited by `maxdepth' and `maxgrowth' of the
+ * lia_t struct, exceeding them is a error that stops the parsing of the
+ * file.
+ * 
+ * @param tk         The token of the macro call.
+ * @param file       The file where this token is.
+ * @param lia        The lia_t struct.
+ * @return token_t*  Last token before the macro's content.
+ */
+token_t *macro_expand(token_t *tk, imp_t *file, lia_t *lia)
+{
+  size_t base = lia->mdepth;
+  macro_frame_t *frame;
+  macro_node_t *child;
+  token_t *next = NULL;
+
+  if ( !macro_push(tk, file, lia) )
+    return NULL;
+
+  while (lia->mdepth > base) {
+    if (file->stop) {
+      lia->mdepth = base;
+      return NULL;
+    }
+
+    frame = &lia->mstack[lia->mdepth - 1];
+    tk = frame->cursor;
+
+    if (tk && tk->type != TK_CLOSEPARENS) {
+      if ( !frame->resumed && (tk->type == TK_ID || tk->type == TK_OPENPARENS)
+          && macro_push(tk, file, lia) )
+        continue;
+
+      frame->resumed = false;
+      child = (tk->type < TK_INVALID) ? frame->node->child[tk->type] : NULL;
+      if (child) {
+        frame->args[frame->argc++] = tk;
+        frame->node = child;
+        frame->cursor = tk->next;
+        continue;
+      }
+
+      if ( !file->stop ) {
+        lia_error(file->filename, tk->line, tk->column,
+          "Macro '%s' don't have a variant with this sequence. Instead try:",
+          frame->macro->name);
+        macro_candidates(frame->node);
+      }
+
+      next = NULL;
+    } else {
+      next = macro_apply(frame, file, lia);
+    }
+
+    /*
+     * The call that failed is taken as a ordinary token at the arguments
+     * of the previous one, the result of a expansion isn't expanded again.
+     */
+    lia->mdepth--;
+    if (lia->mdepth > base) {
+      frame = &lia->mstack[lia->mdepth - 1];
+      frame->resumed = true;
+      if (next)
+        frame->cursor = next->next;
+    }
+  }
+
+  return next;
 }
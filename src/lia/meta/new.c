@@ -84,6 +84,7 @@ token_t *meta_new(KEY_ARGS)
     return NULL;
   }
 
-  lia_cmd_new(lia->cmdtree, name, args, tk);
+  lia_cmd_new(&lia->cmds, name, args, tk);
+  lia->generation++;
   return metanext( lasttype(tk, TK_STRING) );
 }
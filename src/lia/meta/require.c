@@ -11,7 +11,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include "lia/lia.h"
-#include "tree.h"
+#include "map.h"
 
 token_t *meta_require(KEY_ARGS)
 {
@@ -32,7 +32,7 @@ token_t *meta_require(KEY_ARGS)
     else
       strcpy(name, tk->text);
 
-    if ( !tree_find(lia->imptree, hash(name)) ) {
+    if ( !map_find(&lia->imports, hash(name), name) ) {
       lia_error(file->filename, tk->line, tk->column,
         "Required module '%s' not imported yet.", name);
       file->stop = true;
@@ -11,9 +11,63 @@
 #include <string.h>
 #include "lia/lia.h"
 
+/**
+ * @brief Converts a name to the meta-keyword.
+ * 
+ * The candidates are selected by the length and the first character
+ * of the name, so it's compared with one meta-keyword at most.
+ * 
+ * @param name            The name, don't need to be null-terminated
+ * @param length          Length of the name
+ * @return metakeyword_t  The meta-keyword's type
+ * @return META_NONE      If is not a meta-keyword
+ */
+metakeyword_t name2metakey(const char *name, size_t length)
+{
+  const char *key;
+  metakeyword_t type;
+
+  switch (length) {
+  case 2:
+    key = "if";
+    type = META_IF;
+    break;
+  case 3:
+    key = "new";
+    type = META_NEW;
+    break;
+  case 5:
+    key = "macro";
+    type = META_MACRO;
+    break;
+  case 6:
+    if (name[0] == 'i') {
+      key = "import";
+      type = META_IMPORT;
+    } else {
+      key = "action";
+      type = META_ACTION;
+    }
+    break;
+  case 7:
+    key = "require";
+    type = META_REQUIRE;
+    break;
+  default:
+    return META_NONE;
+  }
+
+  if ( memcmp(name, key, length) )
+    return META_NONE;
+
+  return type;
+}
+
 /**
  * @brief Verify if a token is a meta-keyword
  * 
+ * The meta-keyword is recognized at the lexer.
+ * 
  * @param tk              The token to verify
  * @return metakeyword_t  The meta-keyword's type
  * @return META_NONE      If is not a meta-keyword
@@ -22,23 +76,8 @@ metakeyword_t ismetakey(token_t *tk)
 {
   if (tk->type != TK_ID)
     return META_NONE;
-  
-  const char *list[] = {
-    [META_NEW] = "new",
-    [META_IMPORT] = "import",
-    [META_MACRO] = "macro",
-    [META_REQUIRE] = "require",
-    [META_IF] = "if",
-    [META_ACTION] = "action",
-    [META_NONE] = NULL
-  };
-  
-  for (int i = 0; list[i]; i++) {
-    if ( !strcmp(list[i], tk->text) )
-      return i;
-  }
-  
-  return META_NONE;
+
+  return tk->metakey;
 }
 
 /**
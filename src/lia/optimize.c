@@ -0,0 +1,1176 @@
+/**
+ * @file    optimize.c
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Optimizer's passes over the instructions' list
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lia/lia.h"
+
+/**
+ * @brief Gets the procedures called by a instruction, by `call' or by
+ * the operands of a command with the `p' type.
+ * 
+ * @param lia       The lia_t struct
+ * @param inst      The instruction
+ * @param callees   Array of CMD_ARGC elements to receive the tokens with
+ *                  the procedures' names
+ * @return int      The number of procedures
+ */
+int opt_callees(lia_t *lia, inst_t *inst, token_t **callees)
+{
+  token_t *tk = inst->child->next;
+  cmd_t *cmd;
+  int count = 0;
+
+  if (inst->type == INST_CALL) {
+    callees[0] = tk;
+    return 1;
+  }
+
+  if (inst->type != INST_CMD)
+    return 0;
+
+  cmd = map_find(&lia->cmds, inst->child->hashname, inst->child->text);
+  if ( !cmd )
+    return 0;
+
+  for (int i = 0; tk && i < CMD_ARGC; i++) {
+    if (cmd->args[i].type == 'p' && tk->type == TK_ID)
+      callees[count++] = tk;
+
+    if (tk->type == TK_STRING)
+      tk = lasttype(tk, TK_STRING);
+
+    if ( !tk->next )
+      break;
+
+    tk = tk->next->next;
+  }
+
+  return count;
+}
+
+/**
+ * @brief Finds the procedures' blocks at the instructions' list, counting
+ * its static call sites.
+ * 
+ * @param lia            The lia_t struct
+ * @param map            Map to insert the procedures, by name
+ * @param count          Pointer to receive the number of procedures
+ * @return opt_proc_t**  Array of the procedures in source order
+ * @return NULL          If a procedure is redefined or not finalized,
+ *                       these errors are left to the target.
+ */
+opt_proc_t **opt_procs(lia_t *lia, map_t *map, size_t *count)
+{
+  instlist_t *list = &lia->instlist;
+  opt_proc_t **procs = NULL;
+  opt_proc_t *elem;
+  token_t *callees[CMD_ARGC];
+  inst_t *inst;
+  size_t size = 0;
+  int i;
+
+  *count = 0;
+
+  for (i = list->first; i != INST_END; i = list->inst[i].next) {
+    inst = &list->inst[i];
+    if (inst->type != INST_PROC)
+      continue;
+
+    elem = map_insert(map, sizeof *elem, inst->child->next->hashname,
+      inst->child->next->text);
+    if ( !elem )
+      goto fail;
+
+    elem->first = i;
+    elem->order = *count;
+
+    while (inst->type != INST_ENDPROC) {
+      if (inst->next == INST_END)
+        goto fail;
+
+      inst = &list->inst[inst->next];
+    }
+
+    elem->last = inst - list->inst;
+    i = elem->last;
+
+    if (*count >= size) {
+      size = size ? size * 2 : 16;
+
+      opt_proc_t **new = realloc(procs, sizeof *new * size);
+      if ( !new ) {
+        fputs("Optimizer: Out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+      }
+
+      procs = new;
+    }
+
+    procs[(*count)++] = elem;
+  }
+
+  for (i = list->first; i != INST_END; i = list->inst[i].next) {
+    int total = opt_callees(lia, &list->inst[i], callees);
+
+    for (int j = 0; j < total; j++) {
+      elem = map_find(map, callees[j]->hashname, callees[j]->text);
+      if (elem)
+        elem->calls++;
+    }
+  }
+
+  return procs;
+
+fail:
+  free(procs);
+  map_free(map);
+  *count = 0;
+  return NULL;
+}
+
+/**
+ * @brief Marks the procedures called by a instruction as reached, pushing
+ * the new ones to the stack.
+ * 
+ * @param lia      The lia_t struct
+ * @param map      The map of the procedures
+ * @param inst     The instruction
+ * @param stack    The stack of procedures to visit
+ * @param top      Pointer to the top of the stack
+ */
+static void opt_reach(lia_t *lia, map_t *map, inst_t *inst,
+  opt_proc_t **stack, size_t *top)
+{
+  token_t *callees[CMD_ARGC];
+  int total = opt_callees(lia, inst, callees);
+  opt_proc_t *elem;
+
+  for (int i = 0; i < total; i++) {
+    elem = map_find(map, callees[i]->hashname, callees[i]->text);
+    if ( !elem || elem->reached )
+      continue;
+
+    elem->reached = true;
+    stack[(*top)++] = elem;
+  }
+}
+
+/**
+ * @brief Unlinks the procedures not reachable from the main code.
+ * 
+ * The procedures called from the main code are reached, and so the ones
+ * called from a reached procedure. The others are linked in a separated
+ * list, to be compiled only to report its errors.
+ * 
+ * @param lia    The lia_t struct
+ * @return int   Index of the first instruction of the unreachable
+ *               procedures, or INST_END if none
+ */
+int opt_deadprocs(lia_t *lia)
+{
+  instlist_t *list = &lia->instlist;
+  map_t map = {0};
+  size_t count;
+  size_t top = 0;
+  opt_proc_t **procs = opt_procs(lia, &map, &count);
+  opt_proc_t **stack;
+  opt_proc_t *elem;
+  int *link = &list->first;
+  int *deadlink;
+  int dead = INST_END;
+  int last = INST_END;
+  inst_t *inst;
+
+  if ( !procs )
+    return INST_END;
+
+  stack = malloc(sizeof *stack * count);
+  if ( !stack ) {
+    fputs("Optimizer: Out of memory\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  for (int i = list->first; i != INST_END; i = list->inst[i].next) {
+    inst = &list->inst[i];
+
+    if (inst->type == INST_PROC) {
+      elem = map_find(&map, inst->child->next->hashname,
+        inst->child->next->text);
+      i = elem->last;
+      continue;
+    }
+
+    opt_reach(lia, &map, inst, stack, &top);
+  }
+
+  while (top) {
+    elem = stack[--top];
+
+    for (int i = elem->first; ; i = list->inst[i].next) {
+      opt_reach(lia, &map, &list->inst[i], stack, &top);
+      if (i == elem->last)
+        break;
+    }
+  }
+
+  deadlink = &dead;
+  for (int i = list->first; i != INST_END;) {
+    inst = &list->inst[i];
+
+    if (inst->type == INST_PROC) {
+      elem = map_find(&map, inst->child->next->hashname,
+        inst->child->next->text);
+
+      if ( !elem->reached ) {
+        *link = list->inst[elem->last].next;
+        *deadlink = i;
+        deadlink = &list->inst[elem->last].next;
+        *deadlink = INST_END;
+        i = *link;
+        continue;
+      }
+
+      inst = &list->inst[elem->last];
+      i = elem->last;
+    }
+
+    link = &inst->next;
+    last = i;
+    i = inst->next;
+  }
+
+  list->last = last;
+
+  free(stack);
+  free(procs);
+  map_free(&map);
+  return dead;
+}
+
+/** Sorts by number of calls, keeping the source order at ties */
+static int calls_compare(const void *a, const void *b)
+{
+  const opt_proc_t *first = *(opt_proc_t * const *) a;
+  const opt_proc_t *second = *(opt_proc_t * const *) b;
+
+  if (first->calls != second->calls)
+    return (first->calls < second->calls) ? 1 : -1;
+
+  return (first->order > second->order) - (first->order < second->order);
+}
+
+/**
+ * @brief Reorders the procedures by number of static call sites.
+ * 
+ * The procedures are indexed in the order which are compiled and the
+ * code of a call grows with the index, so the most called procedures
+ * are moved to the start of the list.
+ * 
+ * @param lia   The lia_t struct
+ */
+void opt_procorder(lia_t *lia)
+{
+  instlist_t *list = &lia->instlist;
+  map_t map = {0};
+  size_t count;
+  opt_proc_t **procs = opt_procs(lia, &map, &count);
+  opt_proc_t *elem;
+  int *link = &list->first;
+  int last = INST_END;
+  inst_t *inst;
+
+  if ( !procs )
+    return;
+
+  // Unlinking the procedures' blocks from the list.
+  for (int i = list->first; i != INST_END;) {
+    inst = &list->inst[i];
+
+    if (inst->type == INST_PROC) {
+      elem = map_find(&map, inst->child->next->hashname,
+        inst->child->next->text);
+      *link = list->inst[elem->last].next;
+      i = *link;
+      continue;
+    }
+
+    link = &inst->next;
+    last = i;
+    i = inst->next;
+  }
+
+  qsort(procs, count, sizeof *procs, calls_compare);
+
+  list->inst[ procs[count - 1]->last ].next = list->first;
+  for (size_t i = count - 1; i > 0; i--)
+    list->inst[ procs[i - 1]->last ].next = procs[i]->first;
+
+  list->first = procs[0]->first;
+  list->last = (last == INST_END) ? procs[count - 1]->last : last;
+
+  free(procs);
+  map_free(&map);
+}
+
+/**
+ * @brief Declares the procedures in the order which they will be compiled,
+ * giving its indexes. So a procedure can call another compiled after it.
+ * 
+ * @param lia    The lia_t struct
+ * @param first  Index of the first instruction of the list
+ */
+void opt_declare(lia_t *lia, int first)
+{
+  instlist_t *list = &lia->instlist;
+  inst_t *inst;
+
+  for (int i = first; i != INST_END; i = inst->next) {
+    inst = &list->inst[i];
+
+    if (inst->type == INST_PROC && inst->child->next)
+      proc_add(&lia->procs, inst->child->next->text);
+  }
+}
+
+/** Marks the registers read, if not written before by the instruction */
+static void effects_read(opt_effects_t *eff, unsigned int bits)
+{
+  eff->use |= bits & ~eff->def;
+}
+
+/**
+ * @brief Adds the effects of one Ases instruction.
+ * 
+ * @param eff  The effects
+ * @param ch   The instruction
+ */
+static void effects_char(opt_effects_t *eff, int ch)
+{
+  switch (ch) {
+  case '.':
+  case '=':
+  case 'P':
+    eff->def |= OPT_ACC;
+    break;
+  case '+':
+  case '-':
+  case '6':
+  case '7':
+    effects_read(eff, OPT_ACC);
+    eff->def |= OPT_ACC;
+    break;
+  case '0':
+    eff->def |= OPT_ACC;
+    eff->pure = false;
+    break;
+  case '4':
+  case '5':
+    effects_read(eff, OPT_ACC | 1);
+    eff->def |= 1;
+    break;
+  case '9':
+    effects_read(eff, 1 | 2);
+    eff->def |= OPT_ACC;
+    break;
+  case '!':
+  case '1':
+  case '3':
+  case 'p':
+    effects_read(eff, OPT_ACC);
+    eff->pure = false;
+    break;
+  case '>':
+  case '<':
+    eff->pure = false;
+    break;
+  case ' ':
+  case '\n':
+  case '\t':
+    break;
+  default:
+    if (ch >= 'a' && ch <= 'l') {
+      effects_read(eff, OPT_ACC);
+      eff->def |= 1U << (ch - 'a');
+    } else if (ch >= 'A' && ch <= 'L') {
+      effects_read(eff, 1U << (ch - 'A'));
+      eff->def |= OPT_ACC;
+    } else {
+      eff->barrier = true;
+    }
+  }
+}
+
+/**
+ * @brief Adds the effects of the code of reg_compile().
+ * 
+ * @param eff  The effects
+ * @param reg  The register
+ * @param get  0 to set, nonzero to get
+ */
+static void effects_reg(opt_effects_t *eff, reg_t reg, int get)
+{
+  if (reg >= REG_RA && reg <= REG_RL)
+    effects_char(eff, (get ? 'A' : 'a') + reg - REG_RA);
+  else if (reg == REG_DP)
+    effects_char(eff, get ? 'P' : 'p');
+  else if (reg == REG_SS && get)
+    effects_read(eff, OPT_ACC);
+  else if (reg != REG_SS)
+    eff->barrier = true;
+}
+
+/**
+ * @brief Gets the registers read and written by a instruction.
+ * 
+ * Instructions with control flow, calls and the procedures' boundaries
+ * are barriers: they may read any register.
+ * 
+ * @param lia   The lia_t struct
+ * @param inst  The instruction
+ * @param eff   Pointer to receive the effects
+ */
+void opt_effects(lia_t *lia, inst_t *inst, opt_effects_t *eff)
+{
+  token_t *ops[CMD_ARGC] = {NULL};
+  token_t *tk = inst->child->next;
+  cmd_t *cmd;
+  int reg;
+
+  memset(eff, 0, sizeof *eff);
+  eff->pure = true;
+
+  for (int i = 0; tk && i < CMD_ARGC; i++) {
+    ops[i] = tk;
+    if (tk->type == TK_STRING)
+      tk = lasttype(tk, TK_STRING);
+
+    if ( !tk->next )
+      break;
+
+    tk = tk->next->next;
+  }
+
+  reg = (ops[0] && ops[0]->type == TK_REGISTER) ? ops[0]->value : REG_NONE;
+
+  switch (inst->type) {
+  case INST_CMD:
+    cmd = map_find(&lia->cmds, inst->child->hashname, inst->child->text);
+    if ( !cmd ) {
+      eff->barrier = true;
+      break;
+    }
+
+    for (cmd_piece_t *p = cmd->pieces; p < cmd->pieces + cmd->npieces; p++) {
+      if (p->slot == CMD_LITERAL) {
+        for (size_t i = 0; i < p->length; i++)
+          effects_char(eff, cmd->literal[p->offset + i]);
+        continue;
+      }
+
+      switch (cmd->args[p->slot].type) {
+      case 'r':
+        if ( !ops[p->slot] || ops[p->slot]->type != TK_REGISTER )
+          eff->barrier = true;
+        else
+          effects_reg(eff, ops[p->slot]->value, p->get);
+        break;
+      case 'i':
+        eff->def |= OPT_ACC;
+        break;
+      case 's':
+        eff->def |= OPT_ACC;
+        eff->pure = false;
+        break;
+      default:
+        eff->barrier = true;
+      }
+    }
+    break;
+  case INST_LOAD:
+    effects_char(eff, '=');
+    effects_reg(eff, reg, false);
+    break;
+  case INST_POP:
+    effects_char(eff, '<');
+    effects_char(eff, '=');
+    effects_reg(eff, reg, false);
+    break;
+  case INST_STORE:
+  case INST_PUSH:
+    if (reg != REG_NONE)
+      effects_reg(eff, reg, true);
+    else
+      eff->def |= OPT_ACC;
+
+    effects_char(eff, '!');
+    if (inst->type == INST_PUSH)
+      effects_char(eff, '>');
+    break;
+  case INST_FUNC:
+    effects_char(eff, tk->text[0]);
+    break;
+  case INST_ASES:
+    for (tk = inst->child->next; tk && tk->type == TK_STRING; tk = metanext(tk)) {
+      for (int i = 0; tk->text[i]; i++)
+        effects_char(eff, tk->text[i]);
+    }
+    break;
+  case INST_SAY:
+    eff->def |= OPT_ACC;
+    eff->pure = false;
+    break;
+  case INST_ENDIF:
+    // The skipped path is joined at the `if', a barrier.
+    eff->pure = false;
+    break;
+  default:
+    eff->barrier = true;
+  }
+
+  if (eff->barrier) {
+    eff->use = OPT_ALL;
+    eff->def = 0;
+    eff->pure = false;
+  }
+}
+
+/**
+ * @brief Removes the instructions which only write registers never read
+ * after, by a backward liveness analysis.
+ * 
+ * Nothing is live at the end of the main code. The instruction after a
+ * single instruction `if' is kept, it's part of the `if'.
+ * 
+ * @param lia            The lia_t struct
+ * @return unsigned int  The number of instructions removed
+ */
+unsigned int opt_deadstores(lia_t *lia)
+{
+  instlist_t *list = &lia->instlist;
+  opt_effects_t eff;
+  unsigned int live = 0;
+  unsigned int removed = 0;
+  size_t count = 0;
+  int *order;
+  int *link;
+  int i;
+
+  for (i = list->first; i != INST_END; i = list->inst[i].next)
+    count++;
+
+  order = malloc(sizeof *order * (count + 1));
+  if ( !order ) {
+    fputs("Optimizer: Out of memory\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+  count = 0;
+  for (i = list->first; i != INST_END; i = list->inst[i].next)
+    order[count++] = i;
+
+  for (size_t k = count; k-- > 0;) {
+    inst_t *inst = &list->inst[ order[k] ];
+    opt_effects(lia, inst, &eff);
+
+    if (eff.pure && !(eff.def & live)
+        && (k == 0 || list->inst[ order[k - 1] ].type != INST_IF)) {
+      order[k] = INST_END;
+      removed++;
+      continue;
+    }
+
+    live = (live & ~eff.def) | eff.use;
+  }
+
+  link = &list->first;
+  for (size_t k = 0; k < count; k++) {
+    if (order[k] == INST_END)
+      continue;
+
+    *link = order[k];
+    link = &list->inst[ order[k] ].next;
+    list->last = order[k];
+  }
+
+  *link = INST_END;
+  if (list->first == INST_END)
+    list->last = INST_END;
+
+  free(order);
+  return removed;
+}
+
+/** The instruction never falls through the next one */
+#define FLOW_EXIT 1
+
+/** The code after the instruction may be reached by a jump */
+#define FLOW_JOIN 2
+
+/**
+ * @brief Gets how a Ases code changes the control flow.
+ * 
+ * @param code     The code
+ * @param length   Length of the code
+ * @param depth    Pointer to the number of `(' not closed
+ * @return int     FLOW_EXIT and FLOW_JOIN flags
+ */
+static int flow_code(const char *code, size_t length, int *depth)
+{
+  int flow = 0;
+  bool cond = false;
+
+  for (size_t i = 0; i < length; i++) {
+    switch (code[i]) {
+    case '?':
+    case '~':
+      cond = true;
+      continue;
+    case ' ':
+    case '\n':
+    case '\t':
+      continue;
+    case '(':
+      ++*depth;
+      break;
+    case '@':
+      if (*depth > 0)
+        --*depth;
+      else
+        flow |= FLOW_JOIN;
+      break;
+    case '$':
+    case '*':
+      if ( !*depth )
+        flow |= FLOW_JOIN;
+      break;
+    case '3':
+      if ( !*depth && !cond )
+        flow |= FLOW_EXIT;
+      break;
+    }
+
+    cond = false;
+  }
+
+  return flow;
+}
+
+/**
+ * @brief Gets how a instruction changes the control flow.
+ * 
+ * The calls are not joins, they return to the instruction after it.
+ * 
+ * @param lia     The lia_t struct
+ * @param inst    The instruction
+ * @param depth   Pointer to the number of `(' not closed
+ * @return int    FLOW_EXIT and FLOW_JOIN flags
+ */
+static int flow_inst(lia_t *lia, inst_t *inst, int *depth)
+{
+  token_t *tk = inst->child->next;
+  cmd_t *cmd;
+  int flow = 0;
+
+  switch (inst->type) {
+  case INST_CMD:
+    cmd = map_find(&lia->cmds, inst->child->hashname, inst->child->text);
+    if ( !cmd )
+      return FLOW_JOIN;
+
+    for (cmd_piece_t *p = cmd->pieces; p < cmd->pieces + cmd->npieces; p++) {
+      if (p->slot == CMD_LITERAL)
+        flow |= flow_code(cmd->literal + p->offset, p->length, depth);
+    }
+    break;
+  case INST_ASES:
+    for (; tk && tk->type == TK_STRING; tk = metanext(tk))
+      flow |= flow_code(tk->text, strlen(tk->text), depth);
+    break;
+  case INST_FUNC:
+    flow = flow_code(tk->text, 1, depth);
+    break;
+  case INST_IFBLOCK:
+    ++*depth;
+    break;
+  case INST_ENDIF:
+    flow = flow_code("@", 1, depth);
+    break;
+  case INST_RET:
+    flow = FLOW_EXIT;
+    break;
+  case INST_PROC:
+  case INST_ENDPROC:
+    flow = FLOW_JOIN;
+    break;
+  default:
+    break;
+  }
+
+  return flow;
+}
+
+/**
+ * @brief Unlinks the instructions after a `ret' or a exit, up to the next
+ * instruction that may be reached by a jump: the end of a if..endif
+ * block, a loop's start or end or the procedure's boundaries.
+ * 
+ * The unreachable instructions are linked in a separated list, to be
+ * compiled only to report its errors, except a `ret' inside a procedure
+ * which can only be compiled there. A warning is reported at the first
+ * instruction of each unreachable sequence.
+ * 
+ * @param lia    The lia_t struct
+ * @return int   Index of the first unreachable instruction, or INST_END
+ *               if none
+ */
+int opt_unreachable(lia_t *lia)
+{
+  instlist_t *list = &lia->instlist;
+  int *link = &list->first;
+  int *deadlink;
+  int dead = INST_END;
+  int last = INST_END;
+  int depth = 0;
+  int first;
+  int next;
+  int flow;
+  bool unreachable = false;
+  bool warned = false;
+  bool guarded = false;
+  bool inproc = false;
+  inst_t *inst;
+
+  deadlink = &dead;
+  for (int i = list->first; i != INST_END; i = next) {
+    inst = &list->inst[i];
+    next = inst->next;
+
+    if (unreachable) {
+      flow = flow_inst(lia, inst, &depth);
+
+      if ( !(flow & FLOW_JOIN) ) {
+        if ( !warned ) {
+          lia_warning(inst->file->filename, inst->child->line,
+            inst->child->column, "%s", "Unreachable code removed.");
+          warned = true;
+        }
+
+        // The instruction of a single instruction `if' goes with it.
+        first = i;
+        if (inst->type == INST_IF && inst->next != INST_END)
+          inst = &list->inst[inst->next];
+
+        next = inst->next;
+        *link = next;
+
+        if ( !inproc || list->inst[first].type != INST_RET ) {
+          *deadlink = first;
+          deadlink = &inst->next;
+          *deadlink = INST_END;
+        }
+        continue;
+      }
+    }
+
+    if (inst->type == INST_PROC)
+      inproc = true;
+    else if (inst->type == INST_ENDPROC)
+      inproc = false;
+
+    depth = 0;
+    flow = guarded ? 0 : flow_inst(lia, inst, &depth);
+    unreachable = (flow & FLOW_EXIT) && !(flow & FLOW_JOIN);
+    warned = false;
+    depth = 0;
+
+    guarded = inst->type == INST_IF;
+    link = &inst->next;
+    last = i;
+  }
+
+  list->last = last;
+  return dead;
+}
+
+/**
+ * @brief Verifies if the code of a procedure's body does the same inlined.
+ * 
+ * The body can't move dp or read it, nor jump, and can't read the
+ * accumulator or rl before writing them: they have the call's values.
+ * 
+ * @param code     The code
+ * @param length   Length of the code
+ * @return int     Nonzero if can be inlined
+ */
+static int inline_safe(const char *code, size_t length)
+{
+  unsigned int known = 0;
+  unsigned int use;
+  unsigned int def;
+  int depth = 0;
+  bool cond = false;
+
+  for (size_t i = 0; i < length; i++) {
+    int ch = code[i];
+    use = def = 0;
+
+    if ( strchr("<>pP$*", ch) )
+      return false;
+
+    if ( strchr("+-67!134?~abcdefghijkl5", ch) )
+      use |= OPT_ACC;
+
+    if ( strchr(".=09+-67ABCDEFGHIJKL", ch) )
+      def |= OPT_ACC;
+
+    if (ch == 'L')
+      use |= 1U << ('l' - 'a');
+    else if (ch == 'l')
+      def |= 1U << ('l' - 'a');
+
+    if (use & ~known)
+      return false;
+
+    if (ch == '(') {
+      depth++;
+    } else if (ch == '@' && --depth < 0) {
+      return false;
+    } else if ( !cond && !depth ) {
+      known |= def;
+    }
+
+    cond = (ch == '?' || ch == '~');
+  }
+
+  return depth == 0;
+}
+
+/**
+ * @brief Gets the code of a procedure's body and of its return value.
+ * 
+ * The body is compiled as the target does, without known values. Calls,
+ * a `ret' that isn't the final instruction and unbalanced blocks can't be
+ * inlined.
+ * 
+ * @param lia      The lia_t struct
+ * @param elem     The procedure
+ * @param body     Output to receive the body's code
+ * @param ret      Output to receive the code of the return value
+ * @return int     Nonzero if the procedure can be inlined
+ */
+static int inline_body(lia_t *lia, opt_proc_t *elem, out_t *body, out_t *ret)
+{
+  instlist_t *list = &lia->instlist;
+  token_t *callees[CMD_ARGC];
+  int pretty = lia->target->pretty;
+  state_t state = lia->state;
+  inst_t *inst = &list->inst[elem->first];
+  inst_type_t last = INST_PROC;
+  unsigned int errcount;
+  int depth = 0;
+  token_t *tk;
+
+  for (int i = inst->next; i != elem->last; i = inst->next) {
+    inst = &list->inst[i];
+
+    switch (inst->type) {
+    case INST_CMD:
+      if ( !map_find(&lia->cmds, inst->child->hashname, inst->child->text)
+          || opt_callees(lia, inst, callees) )
+        return false;
+      break;
+    case INST_RET:
+      if (inst->next != elem->last || last == INST_IF)
+        return false;
+      break;
+    case INST_IF:
+      if (inst->next == elem->last)
+        return false;
+      break;
+    case INST_IFBLOCK:
+      depth++;
+      break;
+    case INST_ENDIF:
+      if (--depth < 0)
+        return false;
+      break;
+    case INST_LOAD:
+    case INST_STORE:
+    case INST_FUNC:
+    case INST_ASES:
+    case INST_SAY:
+      break;
+    default:
+      return false;
+    }
+
+    for (tk = inst->child->next; tk && tk->type == TK_STRING; tk = metanext(tk)) {
+      for (int j = 0; tk->text[j]; j++) {
+        if (tk->text[j] == '\\' && chresc(tk->text[++j]) < 0)
+          return false;
+      }
+    }
+
+    last = inst->type;
+  }
+
+  if (depth)
+    return false;
+
+  // The errors of the body are reported when the procedure is compiled.
+  errcount = lia->errcount;
+  lia_silent = true;
+  lia->target->pretty = false;
+  state_reset(&lia->state);
+
+  inst = &list->inst[elem->first];
+  for (int i = inst->next; i != elem->last; i = inst->next) {
+    inst = &list->inst[i];
+
+    if (inst->type != INST_RET) {
+      inst = lia->target->compile(body, inst, lia);
+      continue;
+    }
+
+    tk = inst->child->next;
+    if ( !tk )
+      break;
+
+    if (tk->type != TK_REGISTER)
+      imm_compile(ret, tk->value);
+    else if (tk->value == REG_DP)
+      out_putc(ret, 'P');
+    else
+      reg_compile(ret, tk->value, true);
+  }
+
+  // The `endproc' returns zero.
+  if (last != INST_RET)
+    out_putc(ret, '.');
+
+  lia->target->pretty = pretty;
+  lia->state = state;
+  lia_silent = false;
+
+  if (lia->errcount != errcount) {
+    lia->errcount = errcount;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Copies a instruction to a new one, not linked at the list.
+ * 
+ * @param list   The instructions' list
+ * @param from   Index of the instruction to copy
+ * @return int   Index of the new instruction
+ */
+static int inline_copy(instlist_t *list, int from)
+{
+  int last = list->last;
+  int next = list->inst[last].next;
+  inst_t *inst = inst_add(list, list->inst[from].type);
+
+  *inst = list->inst[from];
+  inst->next = INST_END;
+
+  list->inst[last].next = next;
+  list->last = last;
+  return inst - list->inst;
+}
+
+/** Links `next' after the instruction `prev', or at the list's start */
+static void inline_link(instlist_t *list, int prev, int next)
+{
+  if (prev == INST_END)
+    list->first = next;
+  else
+    list->inst[prev].next = next;
+}
+
+/**
+ * @brief Makes a `ases' instruction with the code of the return value.
+ * 
+ * @param lia    The lia_t struct
+ * @param site   Index of the call, to copy its location
+ * @param code   The code
+ * @return int   Index of the new instruction
+ */
+static int inline_ret(lia_t *lia, int site, const char *code)
+{
+  int index = inline_copy(&lia->instlist, site);
+  inst_t *inst = &lia->instlist.inst[index];
+  token_t *tk = tknew(lia);
+  token_t *str = tknew(lia);
+
+  tk->type = TK_ID;
+  tk->key = KEY_ASES;
+  tk->line = inst->child->line;
+  tk->column = inst->child->column;
+  tktext(lia, tk, "ases", 4);
+  tk->next = str;
+
+  str->type = TK_STRING;
+  str->line = tk->line;
+  str->column = tk->column;
+  tktext(lia, str, code, strlen(code));
+  str->last = tk;
+
+  inst->type = INST_ASES;
+  inst->child = tk;
+  return index;
+}
+
+/**
+ * @brief Replaces the calls of small procedures by its body.
+ * 
+ * A procedure is inlined if the body is smaller than the call, or if all
+ * its calls can be inlined and the copies are smaller than the calls plus
+ * the procedure's code, estimating its index by the number of calls as
+ * opt_procorder() sorts them. A procedure hinted with [action inline] is
+ * always inlined if it can be. The calls of a single instruction `if' are
+ * kept.
+ * 
+ * @param lia            The lia_t struct
+ * @return unsigned int  The number of calls replaced
+ */
+unsigned int opt_inline(lia_t *lia)
+{
+  instlist_t *list = &lia->instlist;
+  map_t map = {0};
+  size_t count;
+  opt_proc_t **procs = opt_procs(lia, &map, &count);
+  opt_proc_t *elem;
+  const char **exits;
+  unsigned int inlined = 0;
+  int prev = INST_END;
+  int next;
+  int copy;
+  inst_t *inst;
+  token_t *tk;
+
+  if ( !procs )
+    return 0;
+
+  for (int i = list->first; i != INST_END; prev = i, i = inst->next) {
+    inst = &list->inst[i];
+    if (inst->type != INST_CALL
+        || (prev != INST_END && list->inst[prev].type == INST_IF))
+      continue;
+
+    elem = map_find(&map, inst->child->next->hashname,
+      inst->child->next->text);
+    if (elem)
+      elem->sites++;
+  }
+
+  exits = calloc(count, sizeof *exits);
+  if ( !exits ) {
+    fputs("Optimizer: Out of memory\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  for (size_t k = 0; k < count; k++) {
+    proc_t proc = {0};
+    out_t body;
+    out_t ret;
+    size_t keep;
+    size_t size;
+    bool hint;
+
+    elem = procs[k];
+    inst = &list->inst[elem->first];
+    hint = inst->inline_hint;
+    if ( !elem->sites )
+      continue;
+
+    out_memory(&body);
+    out_memory(&ret);
+
+    if ( inline_body(lia, elem, &body, &ret) ) {
+      out_write(&body, ret.buf, ret.len);
+      out_putc(&ret, '\0');
+
+      if ( inline_safe(body.buf, body.len) ) {
+        size = body.len;
+
+        for (size_t j = 0; j < count; j++)
+          proc.index += procs[j]->calls > elem->calls;
+
+        proc.index += PROCINDEX;
+        proc.linear = lia->target->linearcall;
+        keep = elem->sites * (proc_callsize(&proc) + 1);
+
+        // "$(", the body, the `ret' and the `endproc' with ".*@L+!>"
+        if (elem->sites == elem->calls)
+          keep += 2 + size + 2 * proc_retsize(&proc) + 6;
+
+        if (hint || size * elem->sites < keep)
+          exits[elem->order] = strtab_intern(&lia->strtab, ret.buf,
+            ret.len - 1);
+      }
+    }
+
+    if (hint && !exits[elem->order]) {
+      tk = inst->child->next;
+      lia_warning(inst->file->filename, tk->line, tk->column,
+        "The procedure '%s' can't be inlined.", tk->text);
+    }
+
+    out_free(&body);
+    out_free(&ret);
+  }
+
+  prev = INST_END;
+  for (int i = list->first; i != INST_END; prev = i, i = next) {
+    inst = &list->inst[i];
+    next = inst->next;
+    if (inst->type != INST_CALL
+        || (prev != INST_END && list->inst[prev].type == INST_IF))
+      continue;
+
+    elem = map_find(&map, inst->child->next->hashname,
+      inst->child->next->text);
+    if ( !elem || !exits[elem->order] )
+      continue;
+
+    // The call is unlinked, replaced by the copies of the body.
+    for (int j = list->inst[elem->first].next; j != elem->last;
+         j = list->inst[j].next) {
+      if (list->inst[j].type == INST_RET)
+        break;
+
+      copy = inline_copy(list, j);
+      inline_link(list, prev, copy);
+      prev = copy;
+    }
+
+    if ( *exits[elem->order] ) {
+      copy = inline_ret(lia, i, exits[elem->order]);
+      inline_link(list, prev, copy);
+      prev = copy;
+    }
+
+    inline_link(list, prev, next);
+    if (next == INST_END)
+      list->last = prev;
+
+    // The call isn't the previous instruction anymore.
+    i = prev;
+    inlined++;
+  }
+
+  free(exits);
+  free(procs);
+  map_free(&map);
+  return inlined;
+}
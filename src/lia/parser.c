@@ -61,72 +61,120 @@ int tkseq(token_t *tk, unsigned int number, ...)
 }
 
 /**
- * @brief Inserts a instruction at end of inst_t.
+ * @brief Inserts a instruction at end of the list.
+ * 
+ * The pointers to the instructions are valid only until the next
+ * call, because the array of the list can be moved.
  * 
  * @param list       The list to insert.
  * @param type       The type of the instruction.
  * @return inst_t*   Pointer to the new instruction.
  */
-inst_t *inst_add(inst_t *list, inst_type_t type)
+inst_t *inst_add(instlist_t *list, inst_type_t type)
 {
-  inst_t *last = list;
+  inst_t *new;
 
-  while (list && list->child) {
-    last = list;
-    list = list->next;
-  }
+  if (list->count >= list->size) {
+    int size = list->size ? list->size * 2 : INSTLIST_SIZE;
 
-  if ( !list ) {
-    list = calloc(1, sizeof *list);
-    last->next = list;
+    new = realloc(list->inst, size * sizeof *new);
+    if ( !new ) {
+      fputs("Parser: Out of memory\n", stderr);
+      exit(EXIT_FAILURE);
+    }
+
+    list->inst = new;
+    list->size = size;
   }
 
-  list->type = type;
-  return list;
+  if (list->count)
+    list->inst[list->last].next = list->count;
+  else
+    list->first = list->count;
+
+  list->last = list->count;
+  new = &list->inst[list->count++];
+  memset(new, 0, sizeof *new);
+  new->next = INST_END;
+  new->type = type;
+  return new;
+}
+
+/**
+ * @brief Gets the next instruction of the list.
+ * 
+ * @param list       The list.
+ * @param inst       The instruction.
+ * @return inst_t*   Pointer to the next instruction.
+ * @return NULL      If it's the last instruction.
+ */
+inst_t *inst_next(instlist_t *list, inst_t *inst)
+{
+  if (inst->next == INST_END)
+    return NULL;
+
+  return &list->inst[inst->next];
 }
 
 /**
  * @brief Sets the value of a macro with one token
  * 
- * @param tree       The macro's tree
+ * @param lia        The lia_t struct
+ * @param name       The macro's name
  * @param type       The type of the token
  * @return token_t*  The macro's token at body
  */
-token_t *macro_set(macro_t *tree, char *name, token_type_t type)
+token_t *macro_set(lia_t *lia, char *name, token_type_t type)
 {
-  unsigned long int empty = INITIAL_HASH;
-  macro_t *macro = tree_find(tree, hash(name));
-  if ( !macro ) {
-    macro = tree_insert(tree, sizeof *macro, hash(name));
-    macro->name = name;
-    macro->variants = calloc(1, sizeof (macro_var_t));
-  }
+  unsigned long int hashname = hash(name);
+  macro_t *macro = map_find(&lia->macros, hashname, name);
+  if ( !macro )
+    macro = map_insert(&lia->macros, sizeof *macro, hashname, name);
 
-  macro_var_t *var = tree_find(macro->variants, empty);
+  macro_var_t *var = map_find(&macro->variants, INITIAL_HASH, "");
   if ( !var )
-    var = tree_insert(macro->variants, sizeof *var, empty);
+    var = map_insert(&macro->variants, sizeof *var, INITIAL_HASH, "");
   
-  if ( !var->body )
-    var->body = calloc(1, sizeof (token_t));
+  if ( !var->body ) {
+    var->body = tknew(lia);
+    macro_template(lia, var);
+    macro_trie_add(lia, macro, var);
+  }
   
   var->body->type = type;
+  lia->generation++;
   return var->body;
 }
 
 /**
  * @brief Sets a macro string
  * 
- * @param tree   The macro's tree
+ * @param lia    The lia_t struct
  * @param name   The macro's name
  * @param value  The string to the body
  */
-void macrostr_set(macro_t *tree, char *name, const char *value)
+void macrostr_set(lia_t *lia, char *name, const char *value)
 {
-  token_t *tk = macro_set(tree, name, TK_STRING);
-  strcpy(tk->text, value);
+  token_t *tk = macro_set(lia, name, TK_STRING);
+  tktext(lia, tk, value, strlen(value));
 }
 
 
+/**
+ * @brief Reports a [action inline] that isn't followed by a `proc'
+ * 
+ * @param lia     The Lia struct
+ * @param file    The file struct
+ */
+static void inline_orphan(lia_t *lia, imp_t *file)
+{
+  lia_error(file->filename, lia->inlinenext->line, lia->inlinenext->column,
+    "%s", "Expected a `proc' after the [action inline]");
+
+  lia->inlinenext = NULL;
+  lia->errcount++;
+}
+
 /**
  * @brief Analyzes the syntax of the Lia code
  * 
@@ -138,59 +186,54 @@ int lia_parser(lia_t *lia, imp_t *file)
 {
   token_t *this = file->tklist;
 
-  if ( !lia->proctree )
-    lia->proctree = calloc(1, sizeof (proc_t));
-  if ( !lia->cmdtree )
-    lia->cmdtree = calloc(1, sizeof (cmd_t));
-  if ( !lia->macrotree )
-    lia->macrotree = calloc(1, sizeof (macro_t));
-  if ( !lia->instlist )
-    lia->instlist = calloc(1, sizeof (inst_t));
-  
   /* Declaring initial macros */
   if (lia->target)
-    macrostr_set(lia->macrotree, "TARGET", lia->target->name);
+    macrostr_set(lia, "TARGET", lia->target->name);
 
   while (this && this->type != TK_EOF && !file->stop) {
     this = inst_parser(lia, file, this);
   }
 
+  if (lia->inlinenext)
+    inline_orphan(lia, file);
+
   return lia->errcount;
 }
 
+/** Parsers of the meta-keywords */
+static token_t *( *const metakeys[] )(KEY_ARGS) = {
+  [META_NEW] = meta_new,
+  [META_IMPORT] = meta_import,
+  [META_MACRO] = meta_macro,
+  [META_REQUIRE] = meta_require,
+  [META_IF] = meta_if,
+  [META_ACTION] = meta_action
+};
+
+/** Parsers of the keywords, a name that isn't a keyword is a command */
+static token_t *( *const keys[] )(KEY_ARGS) = {
+  [KEY_NONE] = cmd_verify,
+  [KEY_FUNC] = key_func,
+  [KEY_LOAD] = key_load,
+  [KEY_STORE] = key_store,
+  [KEY_PUSH] = key_push,
+  [KEY_POP] = key_pop,
+  [KEY_CALL] = key_call,
+  [KEY_RET] = key_ret,
+  [KEY_PROC] = key_proc,
+  [KEY_ENDPROC] = key_endproc,
+  [KEY_IF] = key_if,
+  [KEY_ENDIF] = key_endif,
+  [KEY_SAY] = key_say,
+  [KEY_ASES] = key_ases
+};
+
 token_t *inst_parser(lia_t *lia, imp_t *file, token_t *this)
 {
   metakeyword_t meta;
   keyword_t key;
   token_t *tk;
   token_t *next;
-  
-  token_t *( *metakeys[] )(KEY_ARGS) = {
-    [META_NEW] = meta_new,
-    [META_IMPORT] = meta_import,
-    [META_MACRO] = meta_macro,
-    [META_REQUIRE] = meta_require,
-    [META_IF] = meta_if,
-    [META_ACTION] = meta_action
-  };
-
-  token_t *( *keys[] )(KEY_ARGS) = {
-    [KEY_NONE] = cmd_verify,
-    [KEY_FUNC] = key_func,
-    [KEY_LOAD] = key_load,
-    [KEY_STORE] = key_store,
-    [KEY_PUSH] = key_push,
-    [KEY_POP] = key_pop,
-    [KEY_CALL] = key_call,
-    [KEY_RET] = key_ret,
-    [KEY_PROC] = key_proc,
-    [KEY_ENDPROC] = key_endproc,
-    [KEY_IF] = key_if,
-    [KEY_ENDIF] = key_endif,
-    [KEY_SAY] = key_say,
-    [KEY_ASES] = key_ases
-  };
-
 
   switch (this->type) {
   case TK_SEPARATOR:
@@ -247,7 +290,10 @@ token_t *inst_parser(lia_t *lia, imp_t *file, token_t *this)
     next = macro_expand(this, file, lia);
     if ( !next ) {
       this = tknext(this, TK_CLOSEPARENS);
-      lia->errcount++;
+
+      // A exceeded limit of the expansion is already counted.
+      if ( !file->stop )
+        lia->errcount++;
       break;
     }
 
@@ -261,6 +307,9 @@ token_t *inst_parser(lia_t *lia, imp_t *file, token_t *this)
       break;
     }
 
+    if (file->stop)
+      break;
+
     if ( this->next->type == TK_OPENPARENS ) {
       this = tknext(this, TK_CLOSEPARENS);
       lia->errcount++;
@@ -272,13 +321,19 @@ token_t *inst_parser(lia_t *lia, imp_t *file, token_t *this)
       if (tk->type != TK_OPENPARENS && tk->type != TK_ID)
         continue;
 
+      /* Continues from the expansion, the tokens of the call can be moved */
       next = macro_expand(tk, file, lia);
-      if (next) {
-        tk->last->next = next->next;
-      }
+      if (next)
+        tk = next;
     }
 
+    if (file->stop)
+      break;
+
     key = iskey(this);
+    if (lia->inlinenext && key != KEY_PROC)
+      inline_orphan(lia, file);
+
     next = keys[key](this, file, lia);
     if ( !next ) {
       this = tknext(this, TK_SEPARATOR)->last;         
@@ -0,0 +1,215 @@
+/**
+ * @file    peephole.c
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Peephole optimizer of the Ases code
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ * 
+ * The rules only rewrite runs of instructions without control flow, so
+ * `$', `*', `(' and `@' are never touched and the jumps keep its targets.
+ * The procedure's calls are copied as is, because the return address is
+ * computed from the length of the call.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lia/peephole.h"
+#include "lia/procedure.h"
+
+/**
+ * @brief Verifies if the last instructions of the code can be rewritten.
+ * 
+ * @param code     The code
+ * @param length   Length of the code
+ * @param barrier  Start of the code that can be changed
+ * @param n        Number of instructions at the end to rewrite
+ * @return int     Nonzero if they can be rewritten
+ */
+static int peep_tail(const char *code, size_t length, size_t barrier, size_t n)
+{
+  size_t start = length - n;
+
+  if (length < barrier + n)
+    return 0;
+
+  // `?' and `~' execute only the next instruction.
+  return !start || (code[start - 1] != '?' && code[start - 1] != '~');
+}
+
+/** Is a register that can be stored and loaded */
+static int is_register(int ch)
+{
+  return (ch >= 'a' && ch <= 'l') || ch == 'p';
+}
+
+/** Only changes the accumulator */
+static int is_accpure(int ch)
+{
+  return strchr(".+-67=P", ch) || (ch >= 'A' && ch <= 'L');
+}
+
+/** Sets the accumulator without reading it */
+static int is_accset(int ch)
+{
+  return strchr(".=P09", ch) || (ch >= 'A' && ch <= 'L');
+}
+
+/** `+-', `-+', `67', `76', `><' and `<>' */
+static size_t rule_cancel(char *code, size_t length, size_t barrier)
+{
+  static const char pairs[][3] = { "+-", "-+", "67", "76", "><", "<>" };
+
+  if ( !peep_tail(code, length, barrier, 2) )
+    return length;
+
+  for (int i = 0; i < sizeof pairs / sizeof *pairs; i++) {
+    if ( !memcmp(code + length - 2, pairs[i], 2) )
+      return length - 2;
+  }
+
+  return length;
+}
+
+/** `xX' to `x' and `!=' to `!' */
+static size_t rule_reload(char *code, size_t length, size_t barrier)
+{
+  int store;
+  int load;
+
+  if ( !peep_tail(code, length, barrier, 2) )
+    return length;
+
+  store = code[length - 2];
+  load = code[length - 1];
+
+  if ( (is_register(store) && load == store - 'a' + 'A')
+      || (store == '!' && load == '=') )
+    return length - 1;
+
+  return length;
+}
+
+/** `Xx' to `X' and `=!' to `=' */
+static size_t rule_restore(char *code, size_t length, size_t barrier)
+{
+  int load;
+  int store;
+
+  if ( !peep_tail(code, length, barrier, 2) )
+    return length;
+
+  load = code[length - 2];
+  store = code[length - 1];
+
+  if ( (is_register(store) && load == store - 'a' + 'A')
+      || (load == '=' && store == '!') )
+    return length - 1;
+
+  return length;
+}
+
+/** Changes to the accumulator followed by a instruction setting it */
+static size_t rule_deadacc(char *code, size_t length, size_t barrier)
+{
+  if ( !peep_tail(code, length, barrier, 2) )
+    return length;
+
+  if ( is_accpure(code[length - 2]) && is_accset(code[length - 1]) ) {
+    code[length - 2] = code[length - 1];
+    return length - 1;
+  }
+
+  return length;
+}
+
+/** Rules of the peephole optimizer, the index is the bit at the mask */
+const peep_rule_t peep_rules[] = {
+  [PEEP_CANCEL] = { "cancel",
+    "Removes instructions canceling each other, like `+-'.", rule_cancel },
+  [PEEP_RELOAD] = { "reload",
+    "Removes loads of the value just stored, like `bB'.", rule_reload },
+  [PEEP_RESTORE] = { "restore",
+    "Removes stores of the value just loaded, like `Bb'.", rule_restore },
+  [PEEP_DEADACC] = { "deadacc",
+    "Removes changes to the accumulator before setting it.", rule_deadacc },
+  [PEEP_BLANK] = { "blank",
+    "Removes spaces and tabs between the instructions.", NULL },
+  [PEEP_COUNT] = { NULL }
+};
+
+/**
+ * @brief Finds a rule by name.
+ * 
+ * @param name   The name of the rule
+ * @return int   Index of the rule
+ * @return -1    If not found
+ */
+int peep_find(const char *name)
+{
+  for (int i = 0; peep_rules[i].name; i++) {
+    if ( !strcmp(peep_rules[i].name, name) )
+      return i;
+  }
+
+  return -1;
+}
+
+/**
+ * @brief Optimizes a Ases code in place.
+ * 
+ * Each instruction is appended to the result and the rules are applied to
+ * its end until none changes it, so rewrites exposing new ones are taken.
+ * Comments and newlines are copied and work as barriers.
+ * 
+ * @param code     The code
+ * @param length   Length of the code
+ * @param rules    Mask of the enabled rules
+ * @return size_t  The new length of the code
+ */
+size_t peep_optimize(char *code, size_t length, unsigned long int rules)
+{
+  static const size_t callsize = sizeof (PROC_CALL1) - 1;
+  size_t barrier = 0;
+  size_t size = 0;
+  size_t last;
+  size_t i = 0;
+  char ch;
+
+  while (i < length) {
+    ch = code[i];
+
+    if (ch == '#' || ch == '\n'
+        || (length - i >= callsize && !memcmp(code + i, PROC_CALL1, callsize))) {
+      char end = (ch == '#' || ch == '\n') ? '\n' : '*';
+
+      while (i < length && code[i] != end)
+        code[size++] = code[i++];
+
+      if (i < length)
+        code[size++] = code[i++];
+
+      barrier = size;
+      continue;
+    }
+
+    i++;
+    if ( (ch == ' ' || ch == '\t') && (rules & PEEP_BIT(PEEP_BLANK))
+        && peep_tail(code, size + 1, 0, 1) )
+      continue;
+
+    code[size++] = ch;
+
+    do {
+      last = size;
+
+      for (int r = 0; peep_rules[r].name; r++) {
+        if ( (rules & PEEP_BIT(r)) && peep_rules[r].apply )
+          size = peep_rules[r].apply(code, size, barrier);
+      }
+    } while (size != last);
+  }
+
+  return size;
+}
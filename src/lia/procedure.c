@@ -9,73 +9,176 @@
  */
 #include <stdio.h>
 #include "lia/procedure.h"
+#include "lia/cmd.h"
 
 /**
  * @brief Inserts a new procedure or gets your index.
  * 
- * This function is thread-unsafe.
+ * The indexes follow the order of insertion in the map, from PROCINDEX.
  * 
- * @param root       The tree's root
+ * @param procs      The map of procedures
  * @param name       The name of the procedure
  * @return proc_t*   The element of the procedure
  */
-proc_t *proc_add(proc_t *root, char *name)
+proc_t *proc_add(map_t *procs, char *name)
 {
-  static unsigned int index = PROCINDEX;
   unsigned long int hashname = hash(name);
-  proc_t *elem = tree_find(root, hashname);
+  proc_t *elem = map_find(procs, hashname, name);
 
   if (elem)
     return elem;
   
-  elem = tree_insert(root, sizeof (proc_t), hashname);
-  elem->name = name;
-  elem->index = index++;
+  elem = map_insert(procs, sizeof (proc_t), hashname, name);
+  elem->index = PROCINDEX + procs->count - 1;
 
   return elem;
 }
 
+/** Encodings of the procedure's call */
+enum {
+  CALL_LINEAR,    /**< Moves dp to the index, one cell at a time */
+  CALL_IMM,       /**< Sets dp to the index with an immediate */
+  CALL_DOUBLE     /**< Builds the index doubling the accumulator */
+};
+
 /**
- * @brief Writes the procedure's call
+ * @brief Calculates the length of the code to build a value at the
+ * accumulator, doubling it with ra.
  * 
- * @param output   The file to write
- * @param proc     The procedure to make the call
+ * @param value    The value to build, starting from zero
+ * @return size_t  The number of instructions
  */
-void proc_call(FILE *output, proc_t *proc)
+static size_t double_length(unsigned int value)
 {
-  fputs(PROC_CALL1, output);
+  size_t direct = delta_length(value);
+  size_t half;
 
-  for (int i = 0; i < proc->index; i++)
-    putc('>', output);
-  
-  fputs(PROC_CALL2, output);
+  if (value < 2)
+    return direct;
+
+  half = double_length(value / 2) + sizeof (PROC_DOUBLE) - 1 + value % 2;
+  return (half < direct) ? half : direct;
 }
 
 /**
- * @brief Writes the procedure's return instruction without *
+ * @brief Generate the code to build a value at the accumulator, doubling it
+ * with ra.
  * 
- * @param output   The file to write
- * @param proc     The procedure to make the ret instruction
+ * @param output   The output to write
+ * @param value    The value to build, starting from zero
  */
-void proc_ret(FILE *output, proc_t *proc)
+static void double_compile(out_t *output, unsigned int value)
 {
-  unsigned int total = PROC_CALLSIZE + proc->index;
-  fputs("<=", output);
+  if (value < 2 || double_length(value) == delta_length(value)) {
+    delta_compile(output, value);
+    return;
+  }
 
-  for (int i = 0; i < total/10; i++)
-    putc('6', output);
-  
-  total %= 10;
+  double_compile(output, value / 2);
+  out_puts(output, PROC_DOUBLE);
+
+  if (value % 2)
+    out_putc(output, '+');
+}
+
+/**
+ * @brief Chooses the shortest encoding to call a procedure
+ * 
+ * @param proc     The procedure
+ * @param length   Pointer to receive the length of the call
+ * @return int     The encoding
+ */
+static int proc_encoding(proc_t *proc, size_t *length)
+{
+  size_t imm = sizeof (PROC_CALL1) + sizeof (PROC_CALL2)
+    + delta_length(proc->index);
+  size_t dbl = sizeof (PROC_CALL1) + sizeof (PROC_SAVE)
+    + sizeof (PROC_RESTORE) - 3 + double_length(proc->index);
+  int encoding = CALL_LINEAR;
+
+  *length = PROC_CALLSIZE + 1 + proc->index;
+  if (proc->linear)
+    return encoding;
+
+  if (imm < *length) {
+    *length = imm;
+    encoding = CALL_IMM;
+  }
+
+  if (dbl < *length) {
+    *length = dbl;
+    encoding = CALL_DOUBLE;
+  }
+
+  return encoding;
+}
+
+/**
+ * @brief Calculates the number of instructions after $ at the procedure's
+ * call.
+ * 
+ * @param proc     The procedure
+ * @return size_t  The number of instructions
+ */
+size_t proc_callsize(proc_t *proc)
+{
+  size_t length;
 
-  if (total > 5) {
-    putc('6', output);
+  proc_encoding(proc, &length);
+  return length - 1;
+}
 
-    for (int i = 10 - total; i > 0; i--)
-      putc('-', output);
-  } else {
-    for (int i = total; i > 0; i--)
-      putc('+', output);
+/**
+ * @brief Gets the length of the code of proc_ret() plus the jump.
+ * 
+ * @param proc     The procedure
+ * @return size_t  The number of instructions
+ */
+size_t proc_retsize(proc_t *proc)
+{
+  return 4 + delta_length(proc_callsize(proc));
+}
+
+/**
+ * @brief Writes the procedure's call
+ * 
+ * @param output   The output to write
+ * @param proc     The procedure to make the call
+ */
+void proc_call(out_t *output, proc_t *proc)
+{
+  size_t length;
+
+  out_puts(output, PROC_CALL1);
+
+  switch ( proc_encoding(proc, &length) ) {
+  case CALL_LINEAR:
+    out_repeat(output, '>', proc->index);
+    out_puts(output, PROC_CALL2);
+    break;
+  case CALL_IMM:
+    out_putc(output, '.');
+    delta_compile(output, proc->index);
+    out_putc(output, 'p');
+    out_puts(output, PROC_CALL2);
+    break;
+  case CALL_DOUBLE:
+    out_puts(output, PROC_SAVE);
+    double_compile(output, proc->index);
+    out_puts(output, PROC_RESTORE);
+    break;
   }
+}
 
-  fputs("l", output);
+/**
+ * @brief Writes the procedure's return instruction without *
+ * 
+ * @param output   The output to write
+ * @param proc     The procedure to make the ret instruction
+ */
+void proc_ret(out_t *output, proc_t *proc)
+{
+  out_puts(output, "<=");
+  delta_compile(output, proc_callsize(proc));
+  out_putc(output, 'l');
 }
@@ -0,0 +1,163 @@
+/**
+ * @file    state.c
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Tracking of the values known at compile-time
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ * 
+ * The values are followed over straight-line code. Labels (`$'), jumps
+ * (`*'), the end of a skipped block (`@') and the start of a procedure's
+ * body (`(' not conditional) are reached from other places, so there
+ * nothing is known, as after any unknown character.
+ */
+#include <stdio.h>
+#include "lia/lia.h"
+
+/**
+ * @brief Forgets all the known values.
+ * 
+ * @param state  The state
+ */
+void state_reset(state_t *state)
+{
+  state->acc = ACC_UNKNOWN;
+
+  for (int i = 0; i < STATE_REGS; i++)
+    state->reg[i] = ACC_UNKNOWN;
+}
+
+/** Adds to a known value, wrapping at 16 bits */
+static long int state_add(long int value, long int delta)
+{
+  if (value == ACC_UNKNOWN)
+    return ACC_UNKNOWN;
+
+  return (value + delta) & 0xffff;
+}
+
+/**
+ * @brief Follows one Ases instruction.
+ * 
+ * @param state  The state
+ * @param ch     The instruction
+ */
+static void state_step(state_t *state, int ch)
+{
+  long int *a = &state->reg[0];
+  long int *b = &state->reg[1];
+
+  switch (ch) {
+  case '.':
+    state->acc = 0;
+    break;
+  case '+':
+  case '-':
+  case '6':
+  case '7':
+    state->acc = state_add(state->acc, (ch == '+') - (ch == '-')
+      + 10 * ((ch == '6') - (ch == '7')));
+    break;
+  case '4':
+  case '5':
+    if (state->acc == ACC_UNKNOWN)
+      *a = ACC_UNKNOWN;
+    else
+      *a = state_add(*a, (ch == '4') ? state->acc : -state->acc);
+    break;
+  case '9':
+    if (*a == ACC_UNKNOWN || *b == ACC_UNKNOWN)
+      state->acc = ACC_UNKNOWN;
+    else
+      state->acc = (*a > *b) ? 0 : 1;
+    break;
+  case '0':
+  case '=':
+  case 'P':
+    state->acc = ACC_UNKNOWN;
+    break;
+  case '1':
+  case '2':
+  case '3':
+  case '!':
+  case '<':
+  case '>':
+  case 'p':
+  case ' ':
+  case '\t':
+  case '\n':
+    break;
+  default:
+    if (ch >= 'a' && ch <= 'l')
+      state->reg[ch - 'a'] = state->acc;
+    else if (ch >= 'A' && ch <= 'L')
+      state->acc = state->reg[ch - 'A'];
+    else
+      state_reset(state);
+  }
+}
+
+/**
+ * @brief Follows a Ases code, updating the known values.
+ * 
+ * @param state   The state before the code, updated to after it
+ * @param code    The code
+ * @param length  Length of the code
+ */
+void state_track(state_t *state, const char *code, size_t length)
+{
+  state_t taken;
+
+  for (size_t i = 0; i < length; i++) {
+    switch (code[i]) {
+    case '#':
+      while (i < length && code[i] != '\n')
+        i++;
+      break;
+    case '?':
+    case '~':
+      if (++i >= length)
+        break;
+
+      // The next path of a conditional skip or jump is not changed.
+      if (code[i] == '(' || code[i] == '*')
+        break;
+
+      taken = *state;
+      state_step(&taken, code[i]);
+
+      if (state->acc != taken.acc)
+        state->acc = ACC_UNKNOWN;
+
+      for (int r = 0; r < STATE_REGS; r++) {
+        if (state->reg[r] != taken.reg[r])
+          state->reg[r] = ACC_UNKNOWN;
+      }
+      break;
+    default:
+      state_step(state, code[i]);
+    }
+  }
+}
+
+/**
+ * @brief Follows the code of reg_compile().
+ * 
+ * @param state  The state
+ * @param reg    The register
+ * @param get    0 to set, nonzero to get
+ */
+void state_register(state_t *state, reg_t reg, int get)
+{
+  if (reg < REG_RA || reg > REG_RL) {
+    if (reg == REG_DP && get)
+      state->acc = ACC_UNKNOWN;
+    return;
+  }
+
+  if (get)
+    state->acc = state->reg[reg - REG_RA];
+  else
+    state->reg[reg - REG_RA] = state->acc;
+}
@@ -15,26 +15,24 @@
 
 void target_ases_start(ARGTARGET)
 {
-  fputs("#!/usr/bin/env ases\n"
-        "# Lia " LIA_TAG "\n\n",
-        output);
+  out_puts(output, "#!/usr/bin/env ases\n"
+                   "# Lia " LIA_TAG "\n\n");
 
   // Reserving space at start of the memory.
-  for (int i = 0; i < PROCINDEX; i++)
-    putc('>', output);
+  out_repeat(output, '>', PROCINDEX);
   
   if (lia->target->pretty)
-    fputs("\n\n", output);
+    out_puts(output, "\n\n");
 }
 
 void target_ases_end(ARGTARGET)
 {
-  fputs(".3\n", output);
+  out_puts(output, ".3\n");
 }
 
 inst_t *target_ases_compile(ARGCOMPILE)
 {
-  long int lastpos;
+  size_t lastpos;
   long int diff;
   operand_t operands[CMD_ARGC];
   cmd_t *cmd;
@@ -44,6 +42,7 @@ inst_t *target_ases_compile(ARGCOMPILE)
   token_t *tk = inst->child->next;
 
   int pretty = lia->target->pretty;
+  state_t state = lia->state;
 
   for (int i = 0; tk && i < CMD_ARGC; i++) {
     switch (tk->type) {
@@ -51,12 +50,11 @@ inst_t *target_ases_compile(ARGCOMPILE)
     case TK_IMMEDIATE:
       operands[i].imm = tk->value;
       break;
+    case TK_REGISTER:
+      operands[i].reg = tk->value;
+      break;
     case TK_ID:
-      if ( isreg(tk) ) {
-        strcpy(operands[i].reg, tk->text);
-      } else {
-        operands[i].procedure = tk->text;
-      }
+      operands[i].procedure = tk->text;
       break;
     case TK_STRING:
       operands[i].string = tk;
@@ -75,43 +73,44 @@ inst_t *target_ases_compile(ARGCOMPILE)
     tk = tk->next->next;
   }
 
-  lastpos = ftell(output);
+  lastpos = out_tell(output);
 
   switch (inst->type) {
   case INST_CMD:
-    cmd = tree_find( lia->cmdtree, hash(inst->child->text) );
-    lia_cmd_compile(lia->proctree, inst->file->filename,
-      output, cmd, operands);
+    cmd = map_find(&lia->cmds, inst->child->hashname, inst->child->text);
+    lia_cmd_compile(&lia->procs, inst->file->filename,
+      output, cmd, operands, &lia->state);
     break;
   case INST_FUNC:
-    putc(inst->child->next->text[0], output);
+    out_putc(output, inst->child->next->text[0]);
     break;
   case INST_LOAD:
-    putc('=', output);
+    out_putc(output, '=');
     reg_compile(output, operands[0].reg, false);
     break;
   case INST_STORE:
-    if (inst->child->next->type == TK_ID)
+    if (inst->child->next->type == TK_REGISTER)
       reg_compile(output, operands[0].reg, true);
     else
-      imm_compile(output, operands[0].imm);
+      imm_compile_state(output, &lia->state, operands[0].imm);
     
-    putc('!', output);
+    out_putc(output, '!');
     break;
   case INST_PUSH:
-    if (inst->child->next->type == TK_ID)
+    if (inst->child->next->type == TK_REGISTER)
       reg_compile(output, operands[0].reg, true);
     else
-      imm_compile(output, operands[0].imm);
+      imm_compile_state(output, &lia->state, operands[0].imm);
     
-    fputs("!>", output);
+    out_puts(output, "!>");
     break;
   case INST_POP:
-    fputs("<=", output);
+    out_puts(output, "<=");
     reg_compile(output, operands[0].reg, false);
     break;
   case INST_CALL:
-    proc = tree_find(lia->proctree, hash(operands[0].procedure));
+    proc = map_find(&lia->procs, inst->child->next->hashname,
+      operands[0].procedure);
     if ( !proc ) {
       tk = inst->child->next;
       lia_error(inst->file->filename, tk->line, tk->column,
@@ -132,16 +131,17 @@ inst_t *target_ases_compile(ARGCOMPILE)
 
     proc_ret(output, lia->inproc);
     if (inst->child->next) {
-      if (inst->child->next->type == TK_ID)
+      if (inst->child->next->type == TK_REGISTER)
         reg_compile(output, operands[0].reg, true);
       else
         imm_compile(output, operands[0].imm);
     }
-    putc('*', output);
+    out_putc(output, '*');
     break;
   case INST_PROC:
-    proc = tree_find(lia->proctree, hash(operands[0].procedure));
-    if (proc) {
+    proc = map_find(&lia->procs, inst->child->next->hashname,
+      operands[0].procedure);
+    if (proc && proc->defined) {
       tk = inst->child->next;
       lia_error(inst->file->filename, tk->line, tk->column,
         "Redefinition of the '%s' procedure.", tk->text);
@@ -156,9 +156,11 @@ inst_t *target_ases_compile(ARGCOMPILE)
       break;
     }
 
-    lia->inproc = proc_add(lia->proctree, operands[0].procedure);
+    lia->inproc = proc_add(&lia->procs, operands[0].procedure);
+    lia->inproc->linear = lia->target->linearcall;
+    lia->inproc->defined = true;
     lia->thisproc = inst;
-    fputs("$(", output);
+    out_puts(output, "$(");
     break;
   case INST_ENDPROC:
     if ( !lia->inproc ) {
@@ -169,27 +171,27 @@ inst_t *target_ases_compile(ARGCOMPILE)
     }
 
     proc_ret(output, lia->inproc);
-    fputs(".*@L+!>", output);
+    out_puts(output, ".*@L+!>");
     lia->inproc = NULL;
     break;
   case INST_IF:
     if ( !strcmp(inst->child->text, "ifz") )
-      fputs("~(", output);
+      out_puts(output, "~(");
     else
-      fputs("?(", output);
+      out_puts(output, "?(");
     
     lia->target->pretty = false;
-    target_ases_compile(output, inst->next, lia);
+    target_ases_compile(output, inst_next(&lia->instlist, inst), lia);
     lia->target->pretty = pretty;
-    putc('@', output);
+    out_putc(output, '@');
 
-    ret_inst = inst->next;
+    ret_inst = inst_next(&lia->instlist, inst);
     break;
   case INST_IFBLOCK:
     if ( !strcmp(inst->child->text, "ifz") )
-      fputs("~(", output);
+      out_puts(output, "~(");
     else
-      fputs("?(", output);
+      out_puts(output, "?(");
     
     lia_ctx_push(lia, inst, INST_ENDIF);
     break;
@@ -202,15 +204,16 @@ inst_t *target_ases_compile(ARGCOMPILE)
     }
 
     free(ctx);
-    putc('@', output);
+    out_putc(output, '@');
     break;
   case INST_SAY:
-    if ( !str_compile(inst->file->filename, output, inst->child->next) )
+    if ( !str_compile(inst->file->filename, output, inst->child->next,
+        lia->target->strcache, lia->state.acc) )
       lia->errcount++;
     break;
   case INST_ASES:
     for (token_t *tk = inst->child->next; tk && tk->type == TK_STRING; tk = metanext(tk))
-      fputs(tk->text, output);
+      out_puts(output, tk->text);
     break;
   default:
     lia_error(inst->file->filename, inst->child->line, inst->child->column,
@@ -219,37 +222,45 @@ inst_t *target_ases_compile(ARGCOMPILE)
     lia->errcount++;
   }
 
-  diff = 40 - (int) (ftell(output) - lastpos);
+  // Follows the code of the instruction, if it's still at the buffer.
+  lia->state = state;
+  if (output->pos <= lastpos)
+    state_track(&lia->state, output->buf + (lastpos - output->pos),
+      out_tell(output) - lastpos);
+  else
+    state_reset(&lia->state);
+
+  diff = 40 - (long int) (out_tell(output) - lastpos);
   if (diff < 0)
     diff = 2;
 
   if (lia->target->pretty) {
-    fprintf(output, "%-*c# Line %04d: ", (int) diff,
+    out_printf(output, "%-*c# Line %04d: ", (int) diff,
       ' ', inst->child->line);
     
     if (inst->type == INST_IF) {
-      fprintf(output, "%s ", inst->child->text);
-      inst = inst->next;
+      out_printf(output, "%s ", inst->child->text);
+      inst = inst_next(&lia->instlist, inst);
     }
 
     for (token_t *tk = inst->child; tk; tk = tk->next) {
 
       switch (tk->type) {
       case TK_CHAR:
-        fprintf(output, "'%s' ", tk->text);
+        out_printf(output, "'%s' ", tk->text);
         break;
       case TK_STRING:
-        fprintf(output, "\"%s\" ", tk->text);
+        out_printf(output, "\"%s\" ", tk->text);
         break;
       default:
-        fprintf(output, "%s ", tk->text);
+        out_printf(output, "%s ", tk->text);
       }
     }
 
     if (inst->type == INST_ENDPROC)
-      putc('\n', output);
+      out_putc(output, '\n');
 
-    putc('\n', output);
+    out_putc(output, '\n');
   }
 
   return ret_inst;
@@ -24,9 +24,14 @@ int main(int argc, char **argv)
 {
   char defmod[513];
   int opt;
+  bool stats = false;
+  bool dryrun = false;
   char *outname = DEF_OUT;
   target_t target = {
     .pretty = false,
+    .strcache = false,
+    .linearcall = false,
+    .peephole = PEEP_ALL,
     .name = "ases",
     .start = target_ases_start,
     .end = target_ases_end,
@@ -49,7 +54,7 @@ int main(int argc, char **argv)
   GETMOD(defmod);
   path_insert(lia->pathlist, defmod);
 
-  while ( (opt = getopt(argc, argv, "I:o:t:ph")) > 0 ) {
+  while ( (opt = getopt(argc, argv, "I:o:t:m:g:x:pcLnsh")) > 0 ) {
     switch (opt) {
     case 'I':
       path_insert(lia->pathlist, optarg);
@@ -63,9 +68,37 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
       }
       break;
+    case 'm':
+      lia->maxdepth = strtoul(optarg, NULL, 10);
+      break;
+    case 'g':
+      lia->maxgrowth = strtoul(optarg, NULL, 10);
+      break;
+    case 'x':
+      if ( !strcmp(optarg, "all") ) {
+        target.peephole = 0;
+      } else if (peep_find(optarg) >= 0) {
+        target.peephole &= ~PEEP_BIT( peep_find(optarg) );
+      } else {
+        fprintf(stderr, "Peephole's rule '%s' is invalid! See help: lia -h\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
     case 'p':
       target.pretty = true;
       break;
+    case 'c':
+      target.strcache = true;
+      break;
+    case 'L':
+      target.linearcall = true;
+      break;
+    case 'n':
+      dryrun = true;
+      break;
+    case 's':
+      stats = true;
+      break;
     case 'h':
     case '?':
       show_help();
@@ -102,7 +135,22 @@ int main(int argc, char **argv)
       return lia->errcount;
   }
 
+  if (stats) {
+    fprintf(stderr, "Macro's cache: %zu hits, %zu misses\n",
+      lia->memo.hits, lia->memo.misses);
+  }
+
   FILE *output;
+  out_t out;
+
+  if (dryrun) {
+    out_counter(&out);
+    if ( lia_compiler(&out, lia) )
+      return lia->errcount;
+
+    printf("Output size: %zu bytes\n", out_tell(&out));
+    return 0;
+  }
 
   if ( !strcmp(outname, "-") )
     output = stdout;
@@ -114,7 +162,9 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
-  if ( lia_compiler(output, lia) ) {
+  out_file(&out, output);
+  if ( lia_compiler(&out, lia) ) {
+    out_free(&out);
     if (output != stdout) {
       fclose(output);
       remove(outname);
@@ -122,6 +172,17 @@ int main(int argc, char **argv)
     return lia->errcount;
   }
 
+  int error = out_flush(&out);
+  out_free(&out);
+
+  if (output != stdout && fclose(output))
+    error = EOF;
+
+  if (error) {
+    fprintf(stderr, "Error: The file '%s' could not be written.\n", outname);
+    return EXIT_FAILURE;
+  }
+
 #ifndef _WIN32
   chmod(outname, S_IRWXU);
 #endif
@@ -172,12 +233,31 @@ void show_help(void)
     "Usage: lia [options] source1.lia source2.lia ...\n"
     "  -o     Specify the output name. (Default: \"" DEF_OUT "\")\n"
     "  -p     (pretty) If specified, adds comments to the output code.\n"
+    "  -c     Caches a second character at the free cell of the stack\n"
+    "         while printing strings, reducing the size of the code.\n"
+    "         The printing overwrites the memory at dp, a value stored\n"
+    "         there before a `say' is lost.\n"
+    "  -L     Uses the linear encoding of the procedure's calls, with\n"
+    "         a size proportional to the procedure's index.\n"
+    "  -n     (dry run) Only compiles and shows the size of the output,\n"
+    "         without writing it.\n"
+    "  -s     Show statistics of the macro's cache.\n"
     "  -t     Specifies the output target.\n"
+    "  -m     Maximum depth of the macro's expansions. (Default: 1024)\n"
+    "  -g     Maximum number of tokens expanded from macros.\n"
+    "         (Default: 16777216)\n"
+    "  -x     Disables a rule of the peephole optimizer, or all of them\n"
+    "         with `-x all'. It's possible use multiple times.\n"
     "  -I     Define a path to search files in import. It's possible\n"
     "         use multiple times to set more paths.\n"
     "  -h     Show this help message.\n\n"
 
     "TARGETS\n"
-    "  At this moment, only 'ases' target is supported."
+    "  At this moment, only 'ases' target is supported.\n\n"
+
+    "PEEPHOLE RULES"
   );
+
+  for (int i = 0; peep_rules[i].name; i++)
+    printf("  %-8s %s\n", peep_rules[i].name, peep_rules[i].description);
 }
@@ -0,0 +1,165 @@
+/**
+ * @file    map.c
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Hash map using open addressing and Robin Hood hashing
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "map.h"
+
+/** Distance of a slot from the ideal position of its hash */
+#define DISTANCE(map, i, hashname) ( ((i) - (hashname)) & ((map)->size - 1) )
+
+/**
+ * @brief Puts a slot in the map, moving the slots nearer of
+ * their ideal position.
+ * 
+ * @param map    The map
+ * @param slot   The slot to put
+ */
+static void map_place(map_t *map, map_slot_t slot)
+{
+  map_slot_t swap;
+  size_t mask = map->size - 1;
+  size_t dist = 0;
+
+  for (size_t i = slot.hashname & mask; ; i = (i + 1) & mask, dist++) {
+    if ( !map->slots[i].elem ) {
+      map->slots[i] = slot;
+      return;
+    }
+
+    if (DISTANCE(map, i, map->slots[i].hashname) < dist) {
+      swap = map->slots[i];
+      map->slots[i] = slot;
+      slot = swap;
+      dist = DISTANCE(map, i, slot.hashname);
+    }
+  }
+}
+
+/**
+ * @brief Doubles the number of slots of the map
+ * 
+ * @param map    The map
+ * @return int   0 if error, nonzero if all ok.
+ */
+static int map_grow(map_t *map)
+{
+  map_slot_t *slots = map->slots;
+  size_t size = map->size;
+
+  map->size = size ? size * 2 : MAP_SIZE;
+  map->slots = calloc(map->size, sizeof *map->slots);
+  if ( !map->slots ) {
+    map->slots = slots;
+    map->size = size;
+    return 0;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    if (slots[i].elem)
+      map_place(map, slots[i]);
+  }
+
+  free(slots);
+  return 1;
+}
+
+/**
+ * @brief Inserts a new zeroed element in the map
+ * 
+ * @param map       The map
+ * @param size      Size of the element
+ * @param hashname  The hash of the name
+ * @param name      The name, it's not copied
+ * @return void*    Pointer to the new element
+ * @return NULL     If the element is repeated or error
+ */
+void *map_insert(map_t *map, size_t size, unsigned long int hashname, char *name)
+{
+  map_elem_t *elem;
+
+  if ( map_find(map, hashname, name) )
+    return NULL;
+
+  /* Keeps the load factor at a maximum of 7/8 */
+  if ( (map->count + 1) * 8 > map->size * 7 && !map_grow(map) )
+    return NULL;
+
+  elem = calloc(1, size);
+  if ( !elem )
+    return NULL;
+
+  elem->hashname = hashname;
+  elem->name = name;
+
+  map_place(map, (map_slot_t){ hashname, elem });
+  map->count++;
+  return elem;
+}
+
+/**
+ * @brief Find a element in the map
+ * 
+ * @param map       The map
+ * @param hashname  The hash of the name
+ * @param name      The name to verify
+ * @return void*    Pointer to the element
+ * @return NULL     If not found
+ */
+void *map_find(map_t *map, unsigned long int hashname, const char *name)
+{
+  map_elem_t *elem;
+  size_t mask = map->size - 1;
+  size_t dist = 0;
+
+  if ( !map->size )
+    return NULL;
+
+  for (size_t i = hashname & mask; ; i = (i + 1) & mask, dist++) {
+    if ( !map->slots[i].elem || DISTANCE(map, i, map->slots[i].hashname) < dist )
+      return NULL;
+
+    if (map->slots[i].hashname == hashname) {
+      elem = map->slots[i].elem;
+      if ( elem->name == name || !strcmp(elem->name, name) )
+        return elem;
+    }
+  }
+}
+
+/**
+ * @brief Free the map and all its elements
+ * 
+ * @param map  The map
+ */
+void map_free(map_t *map)
+{
+  for (size_t i = 0; i < map->size; i++)
+    free(map->slots[i].elem);
+
+  free(map->slots);
+  memset(map, 0, sizeof *map);
+}
+
+/**
+ * @brief Calls a function in all elements of the map
+ * 
+ * @param map     The map
+ * @param mapper  The callee function.
+ */
+void map_map(map_t *map, void (*mapper)(void *))
+{
+  if ( !mapper )
+    return;
+  
+  for (size_t i = 0; i < map->size; i++) {
+    if (map->slots[i].elem)
+      mapper(map->slots[i].elem);
+  }
+}
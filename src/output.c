@@ -0,0 +1,346 @@
+/**
+ * @file    output.c
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Buffered output with pluggable sinks
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "output.h"
+
+/**
+ * @brief Allocates the buffer of an output
+ * 
+ * @param out    The output
+ * @param size   The new size of the buffer
+ */
+static void out_alloc(out_t *out, size_t size)
+{
+  char *buf = realloc(out->buf, size);
+
+  if ( !buf ) {
+    fputs("Output: Out of memory\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  out->buf = buf;
+  out->size = size;
+}
+
+/*
+ * File's sink: the bytes are kept at a fixed buffer, written to the file
+ * when it's full. After an error, the next bytes are discarded and the
+ * error is returned by out_flush().
+ */
+
+static int file_flush(out_t *out)
+{
+  size_t len = out->len;
+
+  out->pos += len;
+  out->len = 0;
+
+  if ( out->error )
+    return out->error;
+
+  if (len && fwrite(out->buf, 1, len, out->file) != len)
+    out->error = EOF;
+  else if ( fflush(out->file) )
+    out->error = EOF;
+
+  return out->error;
+}
+
+static void file_write(out_t *out, const void *data, size_t size)
+{
+  size_t n;
+
+  while (size) {
+    if (out->len == out->size && file_flush(out)) {
+      out->pos += size;
+      return;
+    }
+
+    n = out->size - out->len;
+    if (n > size)
+      n = size;
+
+    memcpy(out->buf + out->len, data, n);
+    out->len += n;
+    data = (const char *) data + n;
+    size -= n;
+  }
+}
+
+static void file_repeat(out_t *out, int ch, size_t n)
+{
+  size_t part;
+
+  while (n) {
+    if (out->len == out->size && file_flush(out)) {
+      out->pos += n;
+      return;
+    }
+
+    part = out->size - out->len;
+    if (part > n)
+      part = n;
+
+    memset(out->buf + out->len, ch, part);
+    out->len += part;
+    n -= part;
+  }
+}
+
+static const sink_t file_sink = {
+  .write = file_write,
+  .repeat = file_repeat,
+  .flush = file_flush
+};
+
+/*
+ * Memory's sink: the buffer grows to keep all the output.
+ */
+
+static void memory_reserve(out_t *out, size_t size)
+{
+  size_t newsize = out->size ? out->size : OUT_BUFSIZE;
+
+  while (newsize - out->len < size)
+    newsize *= 2;
+
+  out_alloc(out, newsize);
+}
+
+static void memory_write(out_t *out, const void *data, size_t size)
+{
+  memory_reserve(out, size);
+  memcpy(out->buf + out->len, data, size);
+  out->len += size;
+}
+
+static void memory_repeat(out_t *out, int ch, size_t n)
+{
+  memory_reserve(out, n);
+  memset(out->buf + out->len, ch, n);
+  out->len += n;
+}
+
+static int memory_flush(out_t *out)
+{
+  return 0;
+}
+
+static const sink_t memory_sink = {
+  .write = memory_write,
+  .repeat = memory_repeat,
+  .flush = memory_flush
+};
+
+/*
+ * Counter's sink: the bytes are only counted.
+ */
+
+static void counter_write(out_t *out, const void *data, size_t size)
+{
+  out->pos += size;
+}
+
+static void counter_repeat(out_t *out, int ch, size_t n)
+{
+  out->pos += n;
+}
+
+static const sink_t counter_sink = {
+  .write = counter_write,
+  .repeat = counter_repeat,
+  .flush = memory_flush
+};
+
+
+/**
+ * @brief Initializes an output writing to a file
+ * 
+ * The output is written when the buffer is full, or by out_flush().
+ * 
+ * @param out    The output
+ * @param file   The file
+ */
+void out_file(out_t *out, FILE *file)
+{
+  memset(out, 0, sizeof *out);
+  out->sink = &file_sink;
+  out->file = file;
+  out_alloc(out, OUT_BUFSIZE);
+}
+
+/**
+ * @brief Initializes an output kept in memory
+ * 
+ * All the output stays at `buf', with `len' bytes.
+ * 
+ * @param out    The output
+ */
+void out_memory(out_t *out)
+{
+  memset(out, 0, sizeof *out);
+  out->sink = &memory_sink;
+}
+
+/**
+ * @brief Initializes an output that only counts the bytes
+ * 
+ * @param out    The output
+ */
+void out_counter(out_t *out)
+{
+  memset(out, 0, sizeof *out);
+  out->sink = &counter_sink;
+}
+
+/**
+ * @brief Writes a character
+ * 
+ * @param out    The output
+ * @param ch     The character
+ */
+void out_putc(out_t *out, int ch)
+{
+  char c = ch;
+
+  if (out->len < out->size)
+    out->buf[out->len++] = c;
+  else
+    out->sink->write(out, &c, 1);
+}
+
+/**
+ * @brief Writes a string, without the null terminator
+ * 
+ * @param out    The output
+ * @param str    The string
+ */
+void out_puts(out_t *out, const char *str)
+{
+  out_write(out, str, strlen(str));
+}
+
+/**
+ * @brief Writes a sequence of bytes
+ * 
+ * @param out    The output
+ * @param data   The bytes
+ * @param size   The number of bytes
+ */
+void out_write(out_t *out, const void *data, size_t size)
+{
+  if ( !size )
+    return;
+
+  if (out->size - out->len >= size) {
+    memcpy(out->buf + out->len, data, size);
+    out->len += size;
+  } else {
+    out->sink->write(out, data, size);
+  }
+}
+
+/**
+ * @brief Writes the same character many times
+ * 
+ * @param out    The output
+ * @param ch     The character
+ * @param n      How many times to repeat it
+ */
+void out_repeat(out_t *out, int ch, size_t n)
+{
+  if ( !n )
+    return;
+
+  if (out->size - out->len >= n) {
+    memset(out->buf + out->len, ch, n);
+    out->len += n;
+  } else {
+    out->sink->repeat(out, ch, n);
+  }
+}
+
+/**
+ * @brief Writes a formatted string, like fprintf()
+ * 
+ * @param out    The output
+ * @param fmt    The format
+ * @param ...    The arguments of the format
+ */
+void out_printf(out_t *out, const char *fmt, ...)
+{
+  char small[256];
+  char *str = small;
+  va_list ap;
+  int size;
+
+  va_start(ap, fmt);
+  size = vsnprintf(small, sizeof small, fmt, ap);
+  va_end(ap);
+
+  if (size <= 0)
+    return;
+
+  if ((size_t) size >= sizeof small) {
+    str = malloc(size + 1);
+    if ( !str ) {
+      fputs("Output: Out of memory\n", stderr);
+      exit(EXIT_FAILURE);
+    }
+
+    va_start(ap, fmt);
+    vsnprintf(str, size + 1, fmt, ap);
+    va_end(ap);
+  }
+
+  out_write(out, str, size);
+
+  if (str != small)
+    free(str);
+}
+
+/**
+ * @brief Gets the current position, without any system call
+ * 
+ * @param out      The output
+ * @return size_t  Number of bytes written since the start
+ */
+size_t out_tell(out_t *out)
+{
+  return out->pos + out->len;
+}
+
+/**
+ * @brief Writes the buffered bytes to the sink
+ * 
+ * @param out    The output
+ * @return 0     If all ok
+ * @return EOF   If error, here or at a previous write
+ */
+int out_flush(out_t *out)
+{
+  return out->sink->flush(out);
+}
+
+/**
+ * @brief Free the buffer of an output, without flushing it
+ * 
+ * @param out    The output
+ */
+void out_free(out_t *out)
+{
+  free(out->buf);
+  out->buf = NULL;
+  out->len = 0;
+  out->size = 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file    strtab.c
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Table of interned strings
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "strtab.h"
+#include "map.h"
+
+/**
+ * @brief Doubles the number of buckets of the table, exits if out of memory
+ * 
+ * @param tab    The table
+ */
+static void strtab_grow(strtab_t *tab)
+{
+  size_t size = tab->size ? tab->size * 2 : STRTAB_SIZE;
+  istr_t **buckets = calloc(size, sizeof *buckets);
+  istr_t *next;
+
+  if ( !buckets ) {
+    fputs("String table: Out of memory\n", stderr);
+    exit(EXIT_FAILURE);
+  }
+
+  for (size_t i = 0; i < tab->size; i++) {
+    for (istr_t *this = tab->buckets[i]; this; this = next) {
+      next = this->next;
+      this->next = buckets[this->hash & (size - 1)];
+      buckets[this->hash & (size - 1)] = this;
+    }
+  }
+
+  free(tab->buckets);
+  tab->buckets = buckets;
+  tab->size = size;
+}
+
+/**
+ * @brief Interns a string
+ * 
+ * The hash is the same of hash(), so it can be used to search
+ * in the maps.
+ * 
+ * @param tab      The table
+ * @param str      The string, don't need to be null-terminated
+ * @param length   The length of the string
+ * @return char*   The interned null-terminated string
+ */
+char *strtab_intern(strtab_t *tab, const char *str, size_t length)
+{
+  unsigned long int hashname = INITIAL_HASH;
+  istr_t **bucket;
+
+  for (size_t i = 0; i < length; i++)
+    hashname = ( (hashname << 5) + hashname ) + (char) str[i];
+
+  if (tab->count >= tab->size)
+    strtab_grow(tab);
+
+  bucket = &tab->buckets[hashname & (tab->size - 1)];
+  for (istr_t *this = *bucket; this; this = this->next) {
+    if (this->hash == hashname && this->length == length
+        && !memcmp(this->text, str, length))
+      return this->text;
+  }
+
+  istr_t *new = arena_alloc(&tab->arena, sizeof *new + length + 1);
+
+  new->hash = hashname;
+  new->length = length;
+  memcpy(new->text, str, length);
+  new->next = *bucket;
+  *bucket = new;
+  tab->count++;
+
+  return new->text;
+}
+
+/**
+ * @brief Free all the strings of the table
+ * 
+ * @param tab  The table
+ */
+void strtab_free(strtab_t *tab)
+{
+  free(tab->buckets);
+  arena_free(&tab->arena);
+  memset(tab, 0, sizeof *tab);
+}
@@ -0,0 +1,80 @@
+#ifndef _TESTS_FIXTURE_H
+#define _TESTS_FIXTURE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "lia/lia.h"
+
+/** The Ases target to compile the tests' code */
+static inline target_t *fixture_target(void)
+{
+  static target_t target = {
+    .name = "ases",
+    .start = target_ases_start,
+    .end = target_ases_end,
+    .compile = target_ases_compile
+  };
+
+  return &target;
+}
+
+/**
+ * @brief Processes a Lia code to the Ases target
+ * 
+ * @param code     The source code
+ * @return lia_t*  The new lia_t struct
+ */
+static inline lia_t *fixture_parse(const char *code)
+{
+  FILE *input = tmpfile();
+  lia_t *lia = calloc(1, sizeof *lia);
+
+  fputs(code, input);
+  rewind(input);
+
+  lia->target = fixture_target();
+  lia_process("test", input, lia);
+  fclose(input);
+  return lia;
+}
+
+/**
+ * @brief Compiles the processed code, counting the size of the output
+ * 
+ * @param lia     The lia_t struct
+ * @param size    Pointer to receive the size, or NULL
+ * @return int    The number of errors
+ */
+static inline int fixture_compile(lia_t *lia, size_t *size)
+{
+  out_t out;
+  int errcount;
+
+  out_counter(&out);
+  errcount = lia_compiler(&out, lia);
+
+  if (size)
+    *size = out_tell(&out);
+
+  out_free(&out);
+  return errcount;
+}
+
+/**
+ * @brief Counts the instructions linked from the first one
+ * 
+ * @param lia     The lia_t struct
+ * @param first   Index of the first instruction
+ * @return int    The number of instructions
+ */
+static inline int fixture_count(lia_t *lia, int first)
+{
+  int count = 0;
+
+  for (int i = first; i != INST_END; i = lia->instlist.inst[i].next)
+    count++;
+
+  return count;
+}
+
+#endif /* _TESTS_FIXTURE_H */
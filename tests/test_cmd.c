@@ -1,10 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "metric.h"
-#include "lia/cmd.h"
+#include "lia/lia.h"
 
-static void cmd_print(cmd_t *cmd)
+static void cmd_print(void *elem)
 {
+  cmd_t *cmd = elem;
+
   printf("%s ", cmd->name);
   
   for (int i = 0; i < CMD_ARGC; i++)
@@ -13,62 +15,29 @@ static void cmd_print(cmd_t *cmd)
   printf("= \"%s\"\n", cmd->body->text);
 }
 
-static void tree_print(cmd_t *tree, unsigned int level)
-{
-  const int lv = 4;
-  if (tree->right)
-    tree_print(tree->right, level + lv);
-
-  
-  if (level > lv) {
-    printf("%*c+", level - lv + 2, '\0');
-    for (int i = 0; i < lv - 1; i++)
-      putchar('-');
-    
-    putchar(' ');
-  } else if (level == lv) {
-    fputs(" +--- ", stdout);
-  } else {
-    fputs("+ ", stdout);
-  }
-
-  cmd_print(tree);
-  
-  if (tree->left)
-    tree_print(tree->left, level + lv);
-}
-
-
-test_t test_cmdtree(void)
+test_t test_cmdmap(void)
 {
-  cmd_t *tree = calloc(1, sizeof *tree);
+  map_t map = {0};
   token_t body = {
     .text = "XxxX",
     .type = TK_STRING
   };
 
-  lia_cmd_new(tree, "add",  (CMDT){ {'X', 'r'}, {'Y', 'r'}, {0, 0} }, &body);
-  lia_cmd_new(tree, "iadd", (CMDT){ {'X', 'r'}, {'Y', 'i'}, {0, 0} }, &body);
-  lia_cmd_new(tree, "sub",  (CMDT){ {'X', 'r'}, {'Y', 'r'}, {0, 0} }, &body);
-  lia_cmd_new(tree, "isub", (CMDT){ {'X', 'r'}, {'Y', 'i'}, {0, 0} }, &body);
-
-  lia_cmd_new(tree, "xxx", (CMDT){ {'X', 'r'}, {'Y', 'i'}, {0, 0} }, &body);
-  lia_cmd_new(tree, "yyy", (CMDT){ {'X', 'r'}, {'Y', 'i'}, {0, 0} }, &body);
-  lia_cmd_new(tree, "zzz", (CMDT){ {'X', 'r'}, {'Y', 'i'}, {0, 0} }, &body);
+  lia_cmd_new(&map, "add",  (CMDT){ {'X', 'r'}, {'Y', 'r'}, {0, 0} }, &body);
+  lia_cmd_new(&map, "iadd", (CMDT){ {'X', 'r'}, {'Y', 'i'}, {0, 0} }, &body);
+  lia_cmd_new(&map, "sub",  (CMDT){ {'X', 'r'}, {'Y', 'r'}, {0, 0} }, &body);
+  lia_cmd_new(&map, "isub", (CMDT){ {'X', 'r'}, {'Y', 'i'}, {0, 0} }, &body);
 
-  tree_print(tree, 0);
+  lia_cmd_new(&map, "xxx", (CMDT){ {'X', 'r'}, {'Y', 'i'}, {0, 0} }, &body);
+  lia_cmd_new(&map, "yyy", (CMDT){ {'X', 'r'}, {'Y', 'i'}, {0, 0} }, &body);
+  lia_cmd_new(&map, "zzz", (CMDT){ {'X', 'r'}, {'Y', 'i'}, {0, 0} }, &body);
 
-  cmd_t *tst = tree->right;
-
-  if ( tst->hashname <= tst->left->hashname )
-    METRIC_TEST_FAIL("Left field is greater than his parent");
-  
-  if ( tst->hashname >= tst->right->hashname )
-    METRIC_TEST_FAIL("Right field is less than his parent");
+  map_map(&map, cmd_print);
+  METRIC_ASSERT(map.count == 7);
 
   puts("---------------");
 
-  cmd_t *find = tree_find(tree, hash("isub"));
+  cmd_t *find = map_find(&map, hash("isub"), "isub");
 
   if ( !find )
     METRIC_TEST_FAIL("Element not found");
@@ -77,62 +46,267 @@ test_t test_cmdtree(void)
     METRIC_TEST_FAIL("Element not match correct");
   
   cmd_print(find);
-  tree_free(tree);
+  map_free(&map);
   
   METRIC_TEST_OK("");
 }
 
-
 test_t test_cmdcompile(void)
 {
   int ret;
-  cmd_t *tree = calloc(1, sizeof *tree);
-  proc_t *proctree = calloc(1, sizeof *proctree);
+  out_t out;
+  map_t cmds = {0};
+  map_t procs = {0};
   token_t body = {
     .text = "xXYy",
     .type = TK_STRING
   };
 
-  lia_cmd_new(tree, "add",   (CMDT){ {'X', 'r'}, {'Y', 'r'}, CMDNULL }, &body);
-  lia_cmd_new(tree, "set",   (CMDT){ {'X', 'r'}, {'Y', 'i'}, CMDNULL }, &body);
-  lia_cmd_new(tree, "call2", (CMDT){ {'X', 'p'}, CMDNULL, CMDNULL },    &body);
+  lia_cmd_new(&cmds, "add",   (CMDT){ {'X', 'r'}, {'Y', 'r'}, CMDNULL }, &body);
+  lia_cmd_new(&cmds, "set",   (CMDT){ {'X', 'r'}, {'Y', 'i'}, CMDNULL }, &body);
+  lia_cmd_new(&cmds, "call2", (CMDT){ {'X', 'p'}, CMDNULL, CMDNULL },    &body);
+  out_file(&out, stdout);
 
-  ret = lia_cmd_compile(proctree, "test", stdout, tree_find(tree, hash("add")),
-    (OPT){ OPREG("rb"), OPREG("ra"), OPNULL });
-  putchar('\n');
+  ret = lia_cmd_compile(&procs, "test", &out,
+    map_find(&cmds, hash("add"), "add"),
+    (OPT){ OPREG(REG_RB), OPREG(REG_RA), OPNULL }, NULL);
+  out_putc(&out, '\n');
   
   if ( !ret )
     METRIC_TEST_FAIL("add instruction failed");
 
-  ret = lia_cmd_compile(proctree, "test", stdout, tree_find(tree, hash("set")),
-    (OPT){ OPREG("rc"), OPIMM(29), OPNULL });
-  putchar('\n');
+  ret = lia_cmd_compile(&procs, "test", &out,
+    map_find(&cmds, hash("set"), "set"),
+    (OPT){ OPREG(REG_RC), OPIMM(29), OPNULL }, NULL);
+  out_putc(&out, '\n');
   
   if ( !ret )
     METRIC_TEST_FAIL("set instruction failed");
 
-  ret = lia_cmd_compile(proctree, "test", stdout, tree_find(tree, hash("call2")),
-    (OPT){ OPPROC("test"), OPNULL, OPNULL });
-  putchar('\n');
-  ret += lia_cmd_compile(proctree, "test", stdout, tree_find(tree, hash("call2")),
-    (OPT){ OPPROC("proc2"), OPNULL, OPNULL });
-  putchar('\n');
-  ret += lia_cmd_compile(proctree, "test", stdout, tree_find(tree, hash("call2")),
-    (OPT){ OPPROC("test"), OPNULL, OPNULL });
-  putchar('\n');
+  ret = lia_cmd_compile(&procs, "test", &out,
+    map_find(&cmds, hash("call2"), "call2"),
+    (OPT){ OPPROC("test"), OPNULL, OPNULL }, NULL);
+  out_putc(&out, '\n');
+  ret += lia_cmd_compile(&procs, "test", &out,
+    map_find(&cmds, hash("call2"), "call2"),
+    (OPT){ OPPROC("proc2"), OPNULL, OPNULL }, NULL);
+  out_putc(&out, '\n');
+  ret += lia_cmd_compile(&procs, "test", &out,
+    map_find(&cmds, hash("call2"), "call2"),
+    (OPT){ OPPROC("test"), OPNULL, OPNULL }, NULL);
+  out_putc(&out, '\n');
+
+  out_flush(&out);
+  out_free(&out);
 
   if ( !ret )
     METRIC_TEST_FAIL("Call instruction failed");  
 
+  map_free(&cmds);
+  map_free(&procs);
+  METRIC_TEST_OK("");
+}
+
+test_t test_cmdtemplate(void)
+{
+  out_t out;
+  map_t cmds = {0};
+  map_t procs = {0};
+  token_t body2 = {
+    .text = "+y.",
+    .type = TK_STRING
+  };
+  token_t body1 = {
+    .next = &body2,
+    .text = "X+-=!",
+    .type = TK_STRING
+  };
+
+  body2.last = &body1;
+  cmd_t *cmd = lia_cmd_new(&cmds, "mix",
+    (CMDT){ {'X', 'r'}, {'Y', 'r'}, CMDNULL }, &body1);
+
+  /* X, "+-=!+", y, "." */
+  METRIC_ASSERT(cmd->npieces == 4);
+  METRIC_ASSERT(cmd->pieces[1].slot == CMD_LITERAL);
+  METRIC_ASSERT(cmd->pieces[1].length == 5);
+
+  out_memory(&out);
+  lia_cmd_compile(&procs, "test", &out, cmd,
+    (OPT){ OPREG(REG_RB), OPREG(REG_DP), OPNULL }, NULL);
+
+  METRIC_ASSERT(out_tell(&out) == 8);
+  METRIC_ASSERT( !memcmp(out.buf, "B+-=!+p.", 8) );
+  out_free(&out);
+
+  map_map(&cmds, cmd_free);
+  map_free(&cmds);
+  map_free(&procs);
+  METRIC_TEST_OK("");
+}
+
+test_t test_immcompile(void)
+{
+  state_t state;
+  out_t out;
+
+  /* Each sequence must load its value */
+  for (int imm = 0; imm < 256; imm++) {
+    out_memory(&out);
+    imm_compile(&out, imm);
+    state_reset(&state);
+    state_track(&state, out.buf, out.len);
+    METRIC_ASSERT(state.acc == imm);
+    out_free(&out);
+  }
+
+  state_reset(&state);
+  state.acc = 200;
+  out_memory(&out);
+  imm_compile_state(&out, &state, 205);
+  METRIC_ASSERT(out.len == 5 && !memcmp(out.buf, "+++++", 5));
+  out_free(&out);
+
+  state.acc = 250;
+  out_memory(&out);
+  imm_compile_state(&out, &state, 3);
+  METRIC_ASSERT(out.len == 4 && !memcmp(out.buf, ".+++", 4));
+  out_free(&out);
+
+  /* A known register is loaded and changed */
+  state.reg[1] = 100;
+  out_memory(&out);
+  imm_compile_state(&out, &state, 101);
+  METRIC_ASSERT(out.len == 2 && !memcmp(out.buf, "B+", 2));
+  state_track(&state, out.buf, out.len);
+  METRIC_ASSERT(state.acc == 101);
+  out_free(&out);
+
+  METRIC_TEST_OK("");
+}
+
+/** Runs the code of a string, returning the printed text */
+static char *str_run(out_t *out)
+{
+  static char text[256];
+  int acc = 0;
+  int cell = 0;
+  int length = 0;
+
+  for (size_t i = 0; i < out->len; i++) {
+    switch (out->buf[i]) {
+    case '.': acc = 0; break;
+    case '+': acc++; break;
+    case '-': acc--; break;
+    case '6': acc += 10; break;
+    case '7': acc -= 10; break;
+    case '!': cell = acc; break;
+    case '=': acc = cell; break;
+    case '1': text[length++] = acc; break;
+    }
+  }
+
+  text[length] = '\0';
+  return text;
+}
+
+test_t test_strcompile(void)
+{
+  out_t out;
+  token_t second = { .type = TK_STRING, .text = "zzz aaaa\\n" };
+  token_t first = { .type = TK_STRING, .text = "Hello, abcabc ", .next = &second };
+  size_t length;
+
+  out_memory(&out);
+  METRIC_ASSERT(str_compile("test", &out, &first, 0, ACC_UNKNOWN) == &second);
+  METRIC_ASSERT( !strcmp(str_run(&out), "Hello, abcabc zzz aaaa\n") );
+  length = out.len;
+  out_free(&out);
+
+  /* The cached character must only shorten the code */
+  out_memory(&out);
+  str_compile("test", &out, &first, 1, ACC_UNKNOWN);
+  METRIC_ASSERT( !strcmp(str_run(&out), "Hello, abcabc zzz aaaa\n") );
+  METRIC_ASSERT(out.len < length);
+  out_free(&out);
+
+  METRIC_TEST_OK("");
+}
+
+test_t test_state(void)
+{
+  state_t state;
+  out_t out;
+
+  state_reset(&state);
+  state_track(&state, ".66+c.+b", 8);
+  METRIC_ASSERT(state.acc == 1 && state.reg[2] == 21 && state.reg[1] == 1);
+
+  /* A conditional instruction may or not change the value */
+  state_track(&state, "?c?+", 4);
+  METRIC_ASSERT(state.acc == ACC_UNKNOWN);
+  METRIC_ASSERT(state.reg[2] == ACC_UNKNOWN && state.reg[1] == 1);
+
+  /* Nothing is known after a label or the end of a block */
+  state_track(&state, ".$", 2);
+  METRIC_ASSERT(state.acc == ACC_UNKNOWN && state.reg[1] == ACC_UNKNOWN);
+  state_track(&state, ".~(+@", 5);
+  METRIC_ASSERT(state.acc == ACC_UNKNOWN);
+
+  /* An unknown character, as at raw `ases' code, forgets everything */
+  state_track(&state, ".c1! x", 6);
+  METRIC_ASSERT(state.acc == ACC_UNKNOWN && state.reg[2] == ACC_UNKNOWN);
+
+  /* The value is loaded from a register if shorter */
+  state_reset(&state);
+  state.reg[4] = 'A' + 1;
+  out_memory(&out);
+  imm_compile_state(&out, &state, 'A');
+  METRIC_ASSERT(out.len == 2 && !memcmp(out.buf, "E-", 2));
+  out_free(&out);
+
+  state.acc = 'A';
+  out_memory(&out);
+  imm_compile_state(&out, &state, 'A');
+  METRIC_ASSERT(out.len == 0);
+  out_free(&out);
+
+  METRIC_TEST_OK("");
+}
+
+test_t test_map_collision(void)
+{
+  map_t map = {0};
+  cmd_t *first = map_insert(&map, sizeof (cmd_t), 42, "first");
+  cmd_t *second = map_insert(&map, sizeof (cmd_t), 42, "second");
+
+  METRIC_ASSERT(first && second && first != second);
+  METRIC_ASSERT(map_find(&map, 42, "first") == first);
+  METRIC_ASSERT(map_find(&map, 42, "second") == second);
+  METRIC_ASSERT(map_find(&map, 42, "third") == NULL);
+  METRIC_ASSERT(map_insert(&map, sizeof (cmd_t), 42, "first") == NULL);
+
+  /* Forces the map to grow, moving the elements */
+  for (int i = 0; i < 100; i++)
+    map_insert(&map, sizeof (cmd_t), i, "x");
+
+  METRIC_ASSERT(map_find(&map, 42, "first") == first);
+  METRIC_ASSERT(map_find(&map, 42, "second") == second);
+  METRIC_ASSERT(map_find(&map, 99, "x") != NULL);
 
-  tree_free(tree);
+  map_free(&map);
   METRIC_TEST_OK("");
 }
 
 int main(void)
 {
-  METRIC_TEST(test_cmdtree);
+  METRIC_TEST(test_cmdmap);
   METRIC_TEST(test_cmdcompile);
+  METRIC_TEST(test_cmdtemplate);
+  METRIC_TEST(test_immcompile);
+  METRIC_TEST(test_strcompile);
+  METRIC_TEST(test_state);
+  METRIC_TEST(test_map_collision);
 
   METRIC_TEST_END();
   return metric_count_tests_fail;
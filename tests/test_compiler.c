@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include "lia/lia.h"
 #include "metric.h"
+#include "fixture.h"
 
 #define BASENAME "tests/compilation/test%u.lia"
 
@@ -28,6 +29,9 @@ test_t test_compiler(void)
   };
 
   FILE *output = fopen(NULLFILE, "w");
+  out_t out;
+
+  out_file(&out, output);
 
   for (unsigned int i = 1; i < 9999; i++) {
     snprintf(filename, sizeof filename - 1, BASENAME, i);
@@ -52,7 +56,8 @@ test_t test_compiler(void)
       METRIC_TEST_FAIL("Syntactic error");
     }
 
-    lia_compiler(output, lia);
+    lia_compiler(&out, lia);
+    out_flush(&out);
 
     printf(" | %d\n", lia->errcount);
     METRIC_ASSERT(lia->errcount == expected);
@@ -61,13 +66,321 @@ test_t test_compiler(void)
     metric_count_tests_ok++;
   }
 
+  out_free(&out);
   metric_count_tests_ok--;
   METRIC_TEST_OK("");
 }
 
+/**
+ * @brief Compiles a program with the linear calls, where the size grows
+ * with the procedures' indexes. The bodies read the accumulator, so the
+ * calls are not inlined.
+ * 
+ * @param hotfirst   Nonzero to define the most called procedure first
+ * @param index      Pointer to receive the index of the most called one
+ * @return size_t    The size of the code
+ */
+static size_t procorder_size(int hotfirst, unsigned int *index)
+{
+  static char code[2048];
+  target_t target = *fixture_target();
+  size_t length = 0;
+  size_t size;
+  lia_t *lia;
+
+  if (hotfirst)
+    length += sprintf(code + length, "proc hot\n  func 1\nendproc\n");
+
+  for (int i = 0; i < 20; i++) {
+    length += sprintf(code + length,
+      "proc cold%d\n  func 1\nendproc\ncall cold%d\n", i, i);
+  }
+
+  if ( !hotfirst )
+    length += sprintf(code + length, "proc hot\n  func 1\nendproc\n");
+
+  for (int i = 0; i < 10; i++)
+    length += sprintf(code + length, "call hot\n");
+
+  target.linearcall = true;
+  lia = fixture_parse(code);
+  lia->target = &target;
+  fixture_compile(lia, &size);
+
+  *index = ( (proc_t *) map_find(&lia->procs, hash("hot"), "hot") )->index;
+  lia_free(lia);
+  return size;
+}
+
+test_t test_procorder(void)
+{
+  lia_t *lia = fixture_parse(
+    "proc first\n"
+    "endproc\n"
+    "call second\n"
+    "proc second\n"
+    "endproc\n"
+    "call second\n"
+    "call first\n");
+  instlist_t *list = &lia->instlist;
+  inst_t *inst;
+
+  METRIC_ASSERT(lia->errcount == 0);
+  opt_procorder(lia);
+
+  /* The most called procedure goes first, then the main code */
+  inst = &list->inst[list->first];
+  METRIC_ASSERT(inst->type == INST_PROC);
+  METRIC_ASSERT( !strcmp(inst->child->next->text, "second") );
+
+  inst = &list->inst[ list->inst[inst->next].next ];
+  METRIC_ASSERT(inst->type == INST_PROC);
+  METRIC_ASSERT( !strcmp(inst->child->next->text, "first") );
+
+  inst = &list->inst[ list->inst[inst->next].next ];
+  METRIC_ASSERT(inst->type == INST_CALL);
+  METRIC_ASSERT(list->inst[list->last].next == INST_END);
+  METRIC_ASSERT( !strcmp(list->inst[list->last].child->next->text, "first") );
+
+  lia_free(lia);
+
+  /* Defined last, `hot' is still called with the lowest index */
+  unsigned int first;
+  unsigned int last;
+  size_t size = procorder_size(false, &last);
+
+  METRIC_ASSERT(last == PROCINDEX);
+  METRIC_ASSERT(procorder_size(true, &first) == size);
+  METRIC_ASSERT(first == PROCINDEX);
+
+  METRIC_TEST_OK("");
+}
+
+test_t test_procforward(void)
+{
+  /* `big' is called more, so it's compiled before `helper' */
+  lia_t *lia = fixture_parse(
+    "proc helper\n"
+    "endproc\n"
+    "proc big\n"
+    "  call helper\n"
+    "  call helper\n"
+    "endproc\n"
+    "call big\n"
+    "call big\n"
+    "call big\n");
+
+  METRIC_ASSERT(lia->errcount == 0);
+  METRIC_ASSERT(fixture_compile(lia, NULL) == 0);
+
+  lia_free(lia);
+  METRIC_TEST_OK("");
+}
+
+test_t test_deadprocs(void)
+{
+  lia_t *lia = fixture_parse(
+    "proc used\n"
+    "endproc\n"
+    "proc unused\n"
+    "  call used\n"
+    "endproc\n"
+    "proc main\n"
+    "  call used\n"
+    "endproc\n"
+    "call main\n");
+  instlist_t *list = &lia->instlist;
+  int dead;
+
+  METRIC_ASSERT(lia->errcount == 0);
+
+  dead = opt_deadprocs(lia);
+  METRIC_ASSERT(dead != INST_END);
+  METRIC_ASSERT( !strcmp(list->inst[dead].child->next->text, "unused") );
+
+  for (int i = list->first; i != INST_END; i = list->inst[i].next) {
+    if (list->inst[i].type == INST_PROC)
+      METRIC_ASSERT( strcmp(list->inst[i].child->next->text, "unused") );
+  }
+
+  lia_free(lia);
+
+  /* `main' is reordered before `used', which it calls */
+  lia = fixture_parse(
+    "proc used\n"
+    "endproc\n"
+    "proc main\n"
+    "  call used\n"
+    "endproc\n"
+    "call main\n"
+    "call main\n");
+
+  METRIC_ASSERT(fixture_compile(lia, NULL) == 0);
+
+  lia_free(lia);
+  METRIC_TEST_OK("");
+}
+
+test_t test_deadstores(void)
+{
+  lia_t *lia = fixture_parse(
+    "ifz load re\n"
+    "load rd\n"
+    "load rc\n"
+    "store rc\n"
+    "load rf\n");
+  instlist_t *list = &lia->instlist;
+
+  METRIC_ASSERT(lia->errcount == 0);
+
+  /* `load rd' and `load rf' are never read, `load re' is part of the `if' */
+  METRIC_ASSERT(opt_deadstores(lia) == 2);
+
+  for (int i = list->first; i != INST_END; i = list->inst[i].next) {
+    if (list->inst[i].type == INST_LOAD) {
+      METRIC_ASSERT( strcmp(list->inst[i].child->next->text, "rd") );
+      METRIC_ASSERT( strcmp(list->inst[i].child->next->text, "rf") );
+    }
+  }
+
+  METRIC_ASSERT(fixture_count(lia, list->first) == 4);
+  lia_free(lia);
+  METRIC_TEST_OK("");
+}
+
+test_t test_unreachable(void)
+{
+  lia_t *lia = fixture_parse(
+    "proc foo\n"
+    "  ret\n"
+    "  load rc\n"
+    "  ifz\n"
+    "    func 3\n"
+    "  endif\n"
+    "  ifz load rd\n"
+    "endproc\n"
+    "proc bar\n"
+    "  ifz ret\n"
+    "  load ra\n"
+    "endproc\n"
+    "call foo\n"
+    "func 3\n"
+    "load re\n"
+    "load rf\n");
+  instlist_t *list = &lia->instlist;
+
+  METRIC_ASSERT(lia->errcount == 0);
+
+  /* The conditional `ret' doesn't make `load ra' unreachable */
+  METRIC_ASSERT(fixture_count(lia, opt_unreachable(lia)) == 8);
+
+  for (int i = list->first; i != INST_END; i = list->inst[i].next) {
+    if (list->inst[i].type == INST_LOAD)
+      METRIC_ASSERT( !strcmp(list->inst[i].child->next->text, "ra") );
+
+    METRIC_ASSERT(list->inst[i].type != INST_ENDIF);
+  }
+
+  METRIC_ASSERT(fixture_count(lia, list->first) == 10);
+  METRIC_ASSERT(list->inst[list->last].type == INST_FUNC);
+  lia_free(lia);
+
+  /* The removed code is still compiled to report its errors */
+  lia = fixture_parse(
+    "func 3\n"
+    "call nothing\n");
+
+  METRIC_ASSERT(lia->errcount == 0);
+  METRIC_ASSERT(fixture_compile(lia, NULL) == 1);
+
+  lia_free(lia);
+  METRIC_TEST_OK("");
+}
+
+test_t test_inline(void)
+{
+  lia_t *lia = fixture_parse(
+    "proc small\n"
+    "  load rc\n"
+    "endproc\n"
+    "proc value\n"
+    "  ret rd\n"
+    "endproc\n"
+    "proc unsafe\n"
+    "  func 1\n"
+    "endproc\n"
+    "proc big\n"
+    "  say \"A string too long to be copied at each call.\"\n"
+    "endproc\n"
+    "[action inline]\n"
+    "proc hinted\n"
+    "  say \"A string too long to be copied at each call.\"\n"
+    "endproc\n"
+    "call small\n"
+    "call small\n"
+    "call value\n"
+    "call unsafe\n"
+    "call big\n"
+    "call big\n"
+    "call hinted\n"
+    "call hinted\n"
+    "ifz call small\n");
+  instlist_t *list = &lia->instlist;
+  int calls = 0;
+  int rets = 0;
+  inst_t *inst;
+
+  METRIC_ASSERT(lia->errcount == 0);
+
+  /* `unsafe' reads the accumulator, the call of the `if' is kept */
+  METRIC_ASSERT(opt_inline(lia) == 5);
+
+  for (int i = list->first; i != INST_END; i = inst->next) {
+    inst = &list->inst[i];
+
+    if (inst->type == INST_PROC) {
+      i = inst->next;
+      while (list->inst[i].type != INST_ENDPROC)
+        i = list->inst[i].next;
+
+      inst = &list->inst[i];
+    } else if (inst->type == INST_CALL) {
+      METRIC_ASSERT( strcmp(inst->child->next->text, "hinted") );
+      calls++;
+    } else if (inst->type == INST_ASES) {
+      METRIC_ASSERT( !strcmp(inst->child->next->text, "D")
+                  || !strcmp(inst->child->next->text, ".") );
+      rets++;
+    }
+  }
+
+  METRIC_ASSERT(calls == 4);
+  METRIC_ASSERT(rets == 5);
+  lia_free(lia);
+
+  /* The hint must be followed by a `proc', and is forgot after the error */
+  lia = fixture_parse("[action inline]\nload ra\nproc foo\nendproc\n");
+  METRIC_ASSERT(lia->errcount == 1);
+  METRIC_ASSERT( !lia->instlist.inst[1].inline_hint );
+  lia_free(lia);
+
+  lia = fixture_parse("proc foo\nendproc\n[action inline]\n");
+  METRIC_ASSERT(lia->errcount == 1);
+  METRIC_ASSERT( !lia->inlinenext );
+  lia_free(lia);
+
+  METRIC_TEST_OK("");
+}
+
 int main(void)
 {
   METRIC_TEST(test_compiler);
+  METRIC_TEST(test_procorder);
+  METRIC_TEST(test_procforward);
+  METRIC_TEST(test_deadprocs);
+  METRIC_TEST(test_deadstores);
+  METRIC_TEST(test_unreachable);
+  METRIC_TEST(test_inline);
   METRIC_TEST_END();
 
   return metric_count_tests_fail;
@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
 #include "metric.h"
 #include "lia/lia.h"
@@ -14,8 +15,8 @@ test_t test_lexer_code(void)
   const int seqtype[] = {
     TK_OPENBRACKET, TK_ID, TK_STRING, TK_CLOSEBRACKET, TK_SEPARATOR,
     TK_SEPARATOR,
-    TK_ID, TK_ID, TK_COMMA, TK_CHAR, TK_SEPARATOR,
-    TK_ID, TK_ID, TK_COMMA, TK_IMMEDIATE, TK_EOF
+    TK_ID, TK_REGISTER, TK_COMMA, TK_CHAR, TK_SEPARATOR,
+    TK_ID, TK_REGISTER, TK_COMMA, TK_IMMEDIATE, TK_EOF
   };
   const int size = sizeof seqtype / sizeof *seqtype;
   const char types[][16] = {
@@ -29,12 +30,13 @@ test_t test_lexer_code(void)
     [TK_EQUAL] = "EQUAL",
     [TK_IMMEDIATE] = "IMMEDIATE",
     [TK_CHAR] = "CHAR",
-    [TK_STRING] = "STRING"
+    [TK_STRING] = "STRING",
+    [TK_REGISTER] = "REGISTER"
   };
 
   FILE *input = fopen(TESTFILE, "r");
-  token_t *code = lia_lexer(TESTFILE, input);
-  token_t *first = code;
+  lia_t *lia = calloc(1, sizeof *lia);
+  token_t *code = lia_lexer(TESTFILE, input, lia);
 
   if ( !code )
     METRIC_TEST_FAIL("Lexer returned error");
@@ -49,6 +51,9 @@ test_t test_lexer_code(void)
 
     if (code->type != seqtype[i])
       METRIC_TEST_FAIL("Type not matched");
+
+    if (code->type == TK_REGISTER && code->value != REG_SS)
+      METRIC_TEST_FAIL("Register not matched");
     
     
     code = code->next;
@@ -56,7 +61,35 @@ test_t test_lexer_code(void)
       METRIC_TEST_FAIL("Unexpected end of the code");
   }
 
-  tkfree(first);
+  lia_free(lia);
+  METRIC_TEST_OK("");
+}
+
+test_t test_lexer_pipe(void)
+{
+  FILE *input = fopen(TESTFILE, "r");
+  FILE *pipe = popen("cat " TESTFILE, "r");
+  lia_t *lia = calloc(1, sizeof *lia);
+  token_t *mapped = lia_lexer(TESTFILE, input, lia);
+  token_t *piped = lia_lexer(TESTFILE, pipe, lia);
+
+  fclose(input);
+  pclose(pipe);
+
+  if ( !mapped || !piped )
+    METRIC_TEST_FAIL("Lexer returned error");
+
+  for (; mapped && piped; mapped = mapped->next, piped = piped->next) {
+    if (mapped->type != piped->type || mapped->line != piped->line ||
+        mapped->column != piped->column || mapped->text != piped->text)
+      METRIC_TEST_FAIL("Tokens from a pipe not match the mapped file");
+
+    if (mapped->hashname != hash(mapped->text))
+      METRIC_TEST_FAIL("Wrong hash of the interned text");
+  }
+
+  METRIC_ASSERT(!mapped && !piped);
+  lia_free(lia);
   METRIC_TEST_OK("");
 }
 
@@ -64,6 +97,7 @@ test_t test_lexer_code(void)
 int main(void)
 {
   METRIC_TEST(test_lexer_code);
+  METRIC_TEST(test_lexer_pipe);
 
   METRIC_TEST_END();
   return metric_count_tests_fail;
@@ -1,29 +1,19 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "lia/lia.h"
 #include "metric.h"
 
 #define TESTMACRO "tests/macro.lia"
 
-static void macro_print(macro_t *macro)
+static void macro_print(void *elem)
 {
-  printf("%s ->\n", macro->name);
-  tree_map(macro->variants, macro_seq_print);
-}
-
-static void tree_print(macro_t *tree)
-{
-  if (tree->right)
-    tree_print(tree->right);
+  macro_t *macro = elem;
 
-  macro_print(tree);
-  
-  if (tree->left)
-    tree_print(tree->left);
+  printf("%s ->\n", macro->name);
+  map_map(&macro->variants, macro_seq_print);
 }
 
-
-
 test_t test_macros(void)
 {
   FILE *input = fopen(TESTMACRO, "r");
@@ -35,15 +25,164 @@ test_t test_macros(void)
   lia_process(TESTMACRO, input, lia);
 
   puts("--------------");
-  tree_print(lia->macrotree);
+  map_map(&lia->macros, macro_print);
 
   METRIC_ASSERT(lia->errcount == 2);
   METRIC_TEST_OK("");
 }
 
+test_t test_template(void)
+{
+  FILE *input = tmpfile();
+  lia_t *lia = calloc(1, sizeof *lia);
+  macro_t *macro;
+  macro_var_t *variant;
+  macro_node_t *node;
+  char sig[] = {TKSIG(TK_REGISTER), TKSIG(TK_COMMA), TKSIG(TK_REGISTER), 0};
+
+  fputs("[macro swap(a: reg ',' b: reg) = b a x a]\n", input);
+  rewind(input);
+  lia_process("template.lia", input, lia);
+
+  macro = map_find(&lia->macros, hash("swap"), "swap");
+  METRIC_ASSERT(macro != NULL);
+
+  variant = map_find(&macro->variants, hash(sig), sig);
+  METRIC_ASSERT(variant != NULL);
+  METRIC_ASSERT(variant->npieces == 4);
+  METRIC_ASSERT(variant->pieces[0].slot == 2);
+  METRIC_ASSERT(variant->pieces[1].slot == 0);
+  METRIC_ASSERT(variant->pieces[2].slot == MACRO_LITERAL);
+  METRIC_ASSERT(variant->pieces[3].slot == 0);
+
+  node = macro->trie->child[TK_REGISTER]->child[TK_COMMA];
+  METRIC_ASSERT(node->child[TK_REGISTER]->variant == variant);
+  METRIC_ASSERT(node->variant == NULL);
+  METRIC_TEST_OK("");
+}
+
+test_t test_moved(void)
+{
+  FILE *input = tmpfile();
+  lia_t *lia = calloc(1, sizeof *lia);
+  inst_t *inst;
+
+  fputs("[macro two(x: reg) = load x; store x]\ntwo(rd)\n", input);
+  rewind(input);
+  lia_process("moved.lia", input, lia);
+  fclose(input);
+
+  METRIC_ASSERT(lia->errcount == 0);
+  METRIC_ASSERT(lia->instlist.count == 2);
+
+  /* The literal tokens receive the position of the call */
+  inst = &lia->instlist.inst[0];
+  METRIC_ASSERT(inst->type == INST_LOAD);
+  METRIC_ASSERT(inst->child->line == 2 && inst->child->column == 1);
+
+  /* The argument keeps its position, the repeated use is a copy */
+  METRIC_ASSERT( !strcmp(inst->child->next->text, "rd") );
+  METRIC_ASSERT(inst->child->next->line == 2);
+  METRIC_ASSERT(inst->child->next->column == 5);
+
+  METRIC_ASSERT(lia->instlist.inst[1].type == INST_STORE);
+  METRIC_ASSERT(lia->instlist.inst[1].child->next != inst->child->next);
+  METRIC_ASSERT( !strcmp(lia->instlist.inst[1].child->next->text, "rd") );
+  METRIC_ASSERT(lia->instlist.inst[1].child->next->column == 5);
+  METRIC_TEST_OK("");
+}
+
+test_t test_limits(void)
+{
+  FILE *input = tmpfile();
+  lia_t *lia = calloc(1, sizeof *lia);
+
+  fputs("[macro i(x: number) = x]\ni(i(i(i(1))))\n", input);
+  rewind(input);
+  lia->maxdepth = 3;
+  lia_process("depth.lia", input, lia);
+
+  METRIC_ASSERT(lia->errcount == 1);
+  METRIC_ASSERT(lia->mdepth == 0);
+  fclose(input);
+
+  input = tmpfile();
+  lia = calloc(1, sizeof *lia);
+  fputs("[macro loop = loop]\nloop\n", input);
+  rewind(input);
+  lia->maxgrowth = 100;
+  lia_process("growth.lia", input, lia);
+
+  METRIC_ASSERT(lia->errcount == 1);
+  METRIC_ASSERT(lia->growth > 100);
+  fclose(input);
+
+  /* The body of a `expr' is parsed recursively */
+  input = tmpfile();
+  lia = calloc(1, sizeof *lia);
+  fputs("[macro expr(x: number) = (x)]\n(1)\n", input);
+  rewind(input);
+  lia_process("nest.lia", input, lia);
+
+  METRIC_ASSERT(lia->errcount == 1);
+  METRIC_ASSERT(lia->mnest == 0);
+  METRIC_ASSERT(lia->mdepth == 0);
+  fclose(input);
+  METRIC_TEST_OK("");
+}
+
+test_t test_memo(void)
+{
+  FILE *input = tmpfile();
+  lia_t *lia = calloc(1, sizeof *lia);
+  size_t count;
+
+  fputs(
+    "[import \"modules/ases/lia\"]\n"
+    "[macro expr(x: number) = set rc, x]\n"
+    "mov ra, (1)\n"
+    "mov rb, (1)\n"
+    "mov rd, (2)\n", input);
+  rewind(input);
+  lia_process("memo.lia", input, lia);
+
+  METRIC_ASSERT(lia->errcount == 0);
+  METRIC_ASSERT(lia->memo.hits == 1);
+  METRIC_ASSERT(lia->memo.misses == 2);
+
+  /* The hit adds the same instruction again, at the position of the call */
+  count = lia->instlist.count;
+  METRIC_ASSERT(count == 6);
+  METRIC_ASSERT( !strcmp(lia->instlist.inst[2].child->text,
+                         lia->instlist.inst[0].child->text) );
+  METRIC_ASSERT(lia->instlist.inst[0].child->line == 3);
+  METRIC_ASSERT(lia->instlist.inst[2].child->line == 4);
+  METRIC_ASSERT(lia->instlist.inst[2].child->next->line == 4);
+  fclose(input);
+
+  /* Replayed in another file, the instruction is of that file */
+  input = tmpfile();
+  fputs("mov rb, (2)\n", input);
+  rewind(input);
+  lia_process("other.lia", input, lia);
+
+  METRIC_ASSERT(lia->errcount == 0);
+  METRIC_ASSERT(lia->memo.hits == 2);
+  METRIC_ASSERT(lia->instlist.count == count + 2);
+  METRIC_ASSERT( !strcmp(lia->instlist.inst[count].file->filename,
+                         "other.lia") );
+  METRIC_ASSERT( !strcmp(lia->instlist.inst[4].file->filename, "memo.lia") );
+  fclose(input);
+  METRIC_TEST_OK("");
+}
+
 int main(void)
 {
   METRIC_TEST(test_macros);
+  METRIC_TEST(test_template);
+  METRIC_TEST(test_moved);
+  METRIC_TEST(test_limits);
+  METRIC_TEST(test_memo);
 
   METRIC_TEST_END();
   return metric_count_tests_fail;
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "metric.h"
+#include "output.h"
+
+test_t test_memory(void)
+{
+  out_t out;
+
+  out_memory(&out);
+  out_puts(&out, "abc");
+  out_putc(&out, 'd');
+  out_printf(&out, "%d", 123);
+  out_repeat(&out, '+', 3);
+
+  METRIC_ASSERT(out.len == 10);
+  METRIC_ASSERT( !memcmp(out.buf, "abcd123+++", 10) );
+
+  /* The buffer grows to keep all the output */
+  out_repeat(&out, '-', OUT_BUFSIZE * 2);
+  METRIC_ASSERT(out.len == 10 + OUT_BUFSIZE * 2);
+  METRIC_ASSERT(out.buf[out.len - 1] == '-');
+  METRIC_ASSERT(out_tell(&out) == out.len);
+  METRIC_ASSERT(out_flush(&out) == 0);
+
+  out_free(&out);
+  METRIC_TEST_OK("");
+}
+
+test_t test_counter(void)
+{
+  out_t out;
+
+  out_counter(&out);
+  out_puts(&out, "abc");
+  out_putc(&out, 'd');
+  out_printf(&out, "%s", "efg");
+  out_repeat(&out, '>', OUT_BUFSIZE * 3);
+  out_repeat(&out, '<', 0);
+
+  METRIC_ASSERT(out.buf == NULL);
+  METRIC_ASSERT(out_tell(&out) == 7 + OUT_BUFSIZE * 3);
+  METRIC_ASSERT(out_flush(&out) == 0);
+
+  out_free(&out);
+  METRIC_TEST_OK("");
+}
+
+test_t test_file(void)
+{
+  FILE *file = tmpfile();
+  char buf[16];
+  out_t out;
+
+  /* The repetition crosses the end of the buffer */
+  out_file(&out, file);
+  out_repeat(&out, '.', OUT_BUFSIZE - 2);
+  out_repeat(&out, '+', 5);
+  out_puts(&out, "end");
+
+  METRIC_ASSERT(out_tell(&out) == OUT_BUFSIZE + 6);
+  METRIC_ASSERT(out_flush(&out) == 0);
+  out_free(&out);
+
+  METRIC_ASSERT(fseek(file, OUT_BUFSIZE - 3, SEEK_SET) == 0);
+  METRIC_ASSERT(fread(buf, 1, 9, file) == 9);
+  METRIC_ASSERT( !memcmp(buf, ".+++++end", 9) );
+  fclose(file);
+
+  /* A write error is returned by the next flush */
+  file = fopen("tests/test_output.c", "r");
+  METRIC_ASSERT(file != NULL);
+
+  out_file(&out, file);
+  out_repeat(&out, '.', OUT_BUFSIZE * 2);
+  out_puts(&out, "end");
+
+  METRIC_ASSERT(out_tell(&out) == OUT_BUFSIZE * 2 + 3);
+  METRIC_ASSERT(out_flush(&out) == EOF);
+  out_free(&out);
+  fclose(file);
+
+  METRIC_TEST_OK("");
+}
+
+int main(void)
+{
+  METRIC_TEST(test_memory);
+  METRIC_TEST(test_counter);
+  METRIC_TEST(test_file);
+
+  METRIC_TEST_END();
+  return metric_count_tests_fail;
+}
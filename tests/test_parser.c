@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "lia/lia.h"
 #include "metric.h"
 
@@ -7,8 +8,10 @@
 #define TESTINST "tests/instruction.lia"
 #define TESTCMD "tests/cmd.lia"
 
-static void cmd_print(cmd_t *cmd)
+static void cmd_print(void *elem)
 {
+  cmd_t *cmd = elem;
+
   printf("%s ", cmd->name);
   
   for (int i = 0; i < CMD_ARGC; i++)
@@ -17,32 +20,6 @@ static void cmd_print(cmd_t *cmd)
   printf("= \"%s\"\n", cmd->body->text);
 }
 
-static void tree_print(cmd_t *tree, unsigned int level)
-{
-  const int lv = 4;
-  if (tree->right)
-    tree_print(tree->right, level + lv);
-
-  
-  if (level > lv) {
-    printf("%*c+", level - lv + 2, '\0');
-    for (int i = 0; i < lv - 1; i++)
-      putchar('-');
-    
-    putchar(' ');
-  } else if (level == lv) {
-    fputs(" +--- ", stdout);
-  } else {
-    fputs("+ ", stdout);
-  }
-
-  cmd_print(tree);
-  
-  if (tree->left)
-    tree_print(tree->left, level + lv);
-}
-
-
 test_t test_meta(void)
 {
   FILE *input = fopen(TESTMETA, "r");
@@ -50,7 +27,7 @@ test_t test_meta(void)
   
   lia_process(TESTMETA, input, lia);
 
-  tree_print(lia->cmdtree, 0);
+  map_map(&lia->cmds, cmd_print);
 
   if (lia->errcount != 2) {
     METRIC_TEST_FAIL("Error in parsing the code");
@@ -66,15 +43,15 @@ test_t test_instlist(void)
   
   lia_process(TESTINST, input, lia);
 
-  inst_t *this = lia->instlist;
-  while (this) {
+  inst_t *this;
+  for (int i = lia->instlist.first; i != INST_END; i = this->next) {
+    this = &lia->instlist.inst[i];
     printf("%d = %s ", this->type, this->child->text);
 
     for (token_t *tk = this->child; (tk = tk->next);)
       printf("%s ", tk->text);
 
     putchar('\n');
-    this = this->next;
   }
 
   if (lia->errcount != 5)
@@ -90,15 +67,15 @@ test_t test_cmdparsing(void)
   
   lia_process(TESTCMD, input, lia);
 
-  inst_t *this = lia->instlist;
-  while (this) {
+  inst_t *this;
+  for (int i = lia->instlist.first; i != INST_END; i = this->next) {
+    this = &lia->instlist.inst[i];
     printf("%d = %s ", this->type, this->child->text);
 
     for (token_t *tk = this->child; (tk = tk->next);)
       printf("%s ", tk->text);
 
     putchar('\n');
-    this = this->next;
   }
 
   if (lia->errcount != 6)
@@ -107,11 +84,82 @@ test_t test_cmdparsing(void)
   METRIC_TEST_OK("Six errors expected");
 }
 
+test_t test_keywords(void)
+{
+  const char *keys[] = {
+    [KEY_FUNC] = "func",
+    [KEY_LOAD] = "load",
+    [KEY_STORE] = "store",
+    [KEY_PUSH] = "push",
+    [KEY_POP] = "pop",
+    [KEY_CALL] = "call",
+    [KEY_RET] = "ret",
+    [KEY_PROC] = "proc",
+    [KEY_ENDPROC] = "endproc",
+    [KEY_IF] = "ifnz",
+    [KEY_ENDIF] = "endif",
+    [KEY_SAY] = "say",
+    [KEY_ASES] = "ases"
+  };
+  const char *metakeys[] = {
+    [META_NEW] = "new",
+    [META_IMPORT] = "import",
+    [META_MACRO] = "macro",
+    [META_REQUIRE] = "require",
+    [META_IF] = "if",
+    [META_ACTION] = "action"
+  };
+  const char *others[] = {
+    "a", "rc", "ifzz", "endprocs", "calls", "imports", "macr", "news",
+    "sau", "procedure", "ld", "set"
+  };
+
+  for (int i = 0; i < KEY_NONE; i++) {
+    if (name2key(keys[i], strlen(keys[i])) != i)
+      METRIC_TEST_FAIL("Keyword not recognized");
+    
+    if (name2metakey(keys[i], strlen(keys[i])) != META_NONE)
+      METRIC_TEST_FAIL("Keyword recognized as meta-keyword");
+  }
+
+  METRIC_ASSERT(name2key("ifz", 3) == KEY_IF);
+
+  for (int i = 0; i < META_NONE; i++) {
+    if (name2metakey(metakeys[i], strlen(metakeys[i])) != i)
+      METRIC_TEST_FAIL("Meta-keyword not recognized");
+    
+    if (name2key(metakeys[i], strlen(metakeys[i])) != KEY_NONE)
+      METRIC_TEST_FAIL("Meta-keyword recognized as keyword");
+  }
+
+  for (int i = 0; i < sizeof others / sizeof *others; i++) {
+    if (name2key(others[i], strlen(others[i])) != KEY_NONE ||
+        name2metakey(others[i], strlen(others[i])) != META_NONE)
+      METRIC_TEST_FAIL("Name recognized as a keyword");
+  }
+
+  for (int i = 0; i < TK_INVALID; i++) {
+    if ( i == TK_ID || i == TK_IMMEDIATE || i == TK_CHAR ||
+         i == TK_STRING || i == TK_REGISTER || i == TK_EOF )
+      continue;
+    
+    if (name2tktype((char *) tktype2name(i)) != i)
+      METRIC_TEST_FAIL("Token type not recognized");
+  }
+
+  METRIC_ASSERT(name2tktype("reg") == TK_REGISTER);
+  METRIC_ASSERT(name2tktype("number") == TK_IMMEDIATE);
+  METRIC_ASSERT(name2tktype("nums") == TK_INVALID);
+  METRIC_ASSERT(name2tktype("@") == TK_INVALID);
+  METRIC_TEST_OK("");
+}
+
 int main(void)
 {
   METRIC_TEST(test_meta);
   METRIC_TEST(test_instlist);
   METRIC_TEST(test_cmdparsing);
+  METRIC_TEST(test_keywords);
 
   METRIC_TEST_END();
   return metric_count_tests_fail;
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "metric.h"
+#include "lia/lia.h"
+
+/** Optimizes the code, returning nonzero if it gets the expected */
+static int peep_test(const char *code, const char *expected,
+  unsigned long int rules)
+{
+  char buf[256];
+  size_t length;
+
+  strcpy(buf, code);
+  length = peep_optimize(buf, strlen(buf), rules);
+  buf[length] = '\0';
+
+  if ( strcmp(buf, expected) ) {
+    printf("'%s' -> '%s', expected '%s'\n", code, buf, expected);
+    return 0;
+  }
+
+  return 1;
+}
+
+test_t test_peephole(void)
+{
+  METRIC_ASSERT( peep_test("++-->><<", "", PEEP_ALL) );
+  METRIC_ASSERT( peep_test("67+", "+", PEEP_ALL) );
+  METRIC_ASSERT( peep_test("B!><=c", "B!c", PEEP_ALL) );
+  METRIC_ASSERT( peep_test("bBcCPp", "bcP", PEEP_ALL) );
+  METRIC_ASSERT( peep_test(".66+C1", "C1", PEEP_ALL) );
+  METRIC_ASSERT( peep_test("Pb Ka", "PbKa", PEEP_ALL) );
+
+  /* Conditionals apply to the next instruction only */
+  METRIC_ASSERT( peep_test("?+-", "?+-", PEEP_ALL) );
+  METRIC_ASSERT( peep_test("~bB", "~bB", PEEP_ALL) );
+  METRIC_ASSERT( peep_test("? +", "? +", PEEP_ALL) );
+
+  /* Control flow, comments and calls are barriers */
+  METRIC_ASSERT( peep_test("+$-", "+$-", PEEP_ALL) );
+  METRIC_ASSERT( peep_test("+@-(+*-", "+@-(+*-", PEEP_ALL) );
+  METRIC_ASSERT( peep_test("# +-\n+-", "# +-\n", PEEP_ALL) );
+  METRIC_ASSERT( peep_test("+" PROC_CALL1 "-" PROC_CALL2 "-",
+    "+" PROC_CALL1 "-" PROC_CALL2 "-", PEEP_ALL) );
+
+  /* Each rule can be disabled */
+  METRIC_ASSERT( peep_test("+-bB", "bB", PEEP_BIT(PEEP_CANCEL)) );
+  METRIC_ASSERT( peep_test("+-bB", "+-b", PEEP_BIT(PEEP_RELOAD)) );
+  METRIC_ASSERT( peep_test("+ -", "+ -", PEEP_ALL & ~PEEP_BIT(PEEP_BLANK)) );
+  METRIC_ASSERT( peep_test("+.", "+.", 0) );
+
+  METRIC_TEST_OK("");
+}
+
+int main(void)
+{
+  METRIC_TEST(test_peephole);
+
+  METRIC_TEST_END();
+  return metric_count_tests_fail;
+}
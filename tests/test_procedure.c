@@ -14,23 +14,52 @@ test_t test_procedure(void)
     "sqrt",
     "another"
   };
-  proc_t *tree = calloc(1, sizeof *tree);
+  map_t procs = {0};
+  out_t out;
+
+  out_file(&out, stdout);
 
   for (int i = 0; i < size; i++) {
-    list[i] = proc_add(tree, names[i]);
+    list[i] = proc_add(&procs, names[i]);
   }
   
   for (int i = 0; i < size; i++) {
-    if (proc_add(tree, names[i])->index != list[i]->index)
+    if (proc_add(&procs, names[i])->index != list[i]->index)
       METRIC_TEST_FAIL("Index not match");
     
-    printf("%d: ", list[i]->index);
-    proc_call(stdout, list[i]);
-    putchar('\n');
+    out_printf(&out, "%d: ", list[i]->index);
+    proc_call(&out, list[i]);
+    out_putc(&out, '\n');
+
+    out_puts(&out, "   ");
+    proc_ret(&out, list[i]);
+    out_putc(&out, '\n');
+  }
+
+  out_flush(&out);
+  out_free(&out);
+
+  METRIC_TEST_OK("");
+}
+
+test_t test_callsize(void)
+{
+  proc_t proc = {0};
+  out_t out;
+
+  for (proc.index = PROCINDEX; proc.index < 20000; proc.index += 7) {
+    for (proc.linear = 0; proc.linear < 2; proc.linear++) {
+      out_memory(&out);
+      proc_call(&out, &proc);
+
+      if (out.len - 1 != proc_callsize(&proc))
+        METRIC_TEST_FAIL("Size of the call not match");
+      out_free(&out);
+    }
 
-    fputs("   ", stdout);
-    proc_ret(stdout, list[i]);
-    putchar('\n');
+    proc.linear = 0;
+    if (proc_callsize(&proc) > 100)
+      METRIC_TEST_FAIL("Compact call too large");
   }
 
   METRIC_TEST_OK("");
@@ -39,6 +68,7 @@ test_t test_procedure(void)
 int main(void)
 {
   METRIC_TEST(test_procedure);
+  METRIC_TEST(test_callsize);
 
   METRIC_TEST_END();
   return metric_count_tests_fail;
@@ -0,0 +1,86 @@
+/**
+ * @file    chrtab.c
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Generates the table of the shortest Ases sequences to change
+ *          the accumulator from one character to another, used by
+ *          str_compile().
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ * 
+ * Usage: chrtab > include/lia/chr_table.h
+ * 
+ * Each entry is packed in 16 bits, see the CHR_* macros at the output.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Packs the shortest sequence adding a value to the accumulator,
+ * using only `6', `7', `+' and `-'.
+ * 
+ * @param delta   The value to add
+ * @return int    The packed sequence
+ */
+static int pack(int delta)
+{
+  int neg = (delta < 0);
+  int total = abs(delta);
+  int tens = total / 10;
+  int ones = total % 10;
+  int onesneg = neg;
+
+  if (ones > 5) {
+    tens++;
+    ones = 10 - ones;
+    onesneg = !neg;
+  }
+
+  return tens | (neg << 5) | (ones << 6) | (onesneg << 9);
+}
+
+/** Length of a packed sequence */
+static int length(int entry)
+{
+  return (entry & 31) + ((entry >> 6) & 7) + ((entry >> 10) & 1);
+}
+
+int main(void)
+{
+  int direct;
+  int reset;
+
+  puts("/* Generated by tools/chrtab.c, don't edit. */\n"
+       "#ifndef _LIA_CHR_TABLE_H\n"
+       "#define _LIA_CHR_TABLE_H\n\n"
+       "#include <stdint.h>\n\n"
+       "#define CHR_TENS(e)     ( (e) & 31 )\n"
+       "#define CHR_TENSCH(e)   ( ((e) >> 5) & 1 ? '7' : '6' )\n"
+       "#define CHR_ONES(e)     ( ((e) >> 6) & 7 )\n"
+       "#define CHR_ONESCH(e)   ( ((e) >> 9) & 1 ? '-' : '+' )\n"
+       "#define CHR_RESET(e)    ( ((e) >> 10) & 1 )\n"
+       "#define CHR_LENGTH(e)   ( CHR_TENS(e) + CHR_ONES(e) + CHR_RESET(e) )\n\n"
+       "/**\n"
+       " * Shortest sequence from the character at the accumulator (first index)\n"
+       " * to another (second index), maybe resetting it with `.' first.\n"
+       " */\n"
+       "static const uint16_t chr_table[256][256] = {");
+
+  for (int from = 0; from < 256; from++) {
+    fputs("  {", stdout);
+    for (int to = 0; to < 256; to++) {
+      direct = pack(to - from);
+      reset = pack(to) | (1 << 10);
+      if (length(reset) < length(direct))
+        direct = reset;
+
+      printf("%s%d%s", to % 16 ? " " : "\n    ", direct, to < 255 ? "," : "");
+    }
+    puts(from < 255 ? "\n  }," : "\n  }");
+  }
+
+  puts("};\n\n"
+       "#endif /* _LIA_CHR_TABLE_H */");
+  return 0;
+}
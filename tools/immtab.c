@@ -0,0 +1,97 @@
+/**
+ * @file    immtab.c
+ * @author  Luiz Felipe (felipe.silva337@yahoo.com)
+ * @brief   Generates the table of the shortest Ases sequences to load
+ *          each immediate value, used by imm_compile().
+ * @version 0.1
+ * @date    2026-10-18
+ * 
+ * @copyright Copyright (c) 2026 Luiz Felipe
+ * 
+ * Usage: immtab > include/lia/imm_table.h
+ */
+#include <stdio.h>
+#include <string.h>
+
+/** The accumulator of Ases has 16 bits */
+#define ACC_SIZE 65536
+
+/** Instructions changing the accumulator, in the order they are emitted */
+static const struct {
+  char ch;
+  int delta;
+} ops[] = {
+  {'6', 10},
+  {'7', -10},
+  {'+', 1},
+  {'-', -1}
+};
+
+#define NOPS ( sizeof ops / sizeof *ops )
+
+static int dist[ACC_SIZE];
+static int from[ACC_SIZE];
+static int opof[ACC_SIZE];
+static int queue[ACC_SIZE];
+
+int main(void)
+{
+  int head = 0;
+  int tail = 0;
+  int count[NOPS];
+  int value;
+  int next;
+
+  /* Breadth-first search from the value 0, set by '.' */
+  memset(dist, -1, sizeof dist);
+  dist[0] = 0;
+  queue[tail++] = 0;
+
+  while (head < tail) {
+    value = queue[head++];
+    for (int i = 0; i < NOPS; i++) {
+      next = (value + ops[i].delta + ACC_SIZE) % ACC_SIZE;
+      if (dist[next] >= 0)
+        continue;
+
+      dist[next] = dist[value] + 1;
+      from[next] = value;
+      opof[next] = i;
+      queue[tail++] = next;
+    }
+  }
+
+  puts("/* Generated by tools/immtab.c, don't edit. */\n"
+       "#ifndef _LIA_IMM_TABLE_H\n"
+       "#define _LIA_IMM_TABLE_H\n\n"
+       "/** Shortest sequence to load each immediate value */\n"
+       "static const char *const imm_table[256] = {");
+
+  for (int imm = 0; imm < 256; imm++) {
+    memset(count, 0, sizeof count);
+    for (value = imm; value; value = from[value])
+      count[ opof[value] ]++;
+
+    /* The instructions commute, so they are emitted grouped */
+    fputs("  \".", stdout);
+    for (int i = 0; i < NOPS; i++) {
+      for (int n = 0; n < count[i]; n++)
+        putchar(ops[i].ch);
+    }
+
+    puts(imm < 255 ? "\"," : "\"");
+  }
+
+  puts("};\n\n"
+       "/** Length of each sequence of imm_table */\n"
+       "static const unsigned char imm_length[256] = {");
+
+  for (int imm = 0; imm < 256; imm++) {
+    printf("%s%d%s", imm % 16 ? " " : "  ", dist[imm] + 1,
+      imm == 255 ? "\n" : (imm % 16 == 15 ? ",\n" : ","));
+  }
+
+  puts("};\n\n"
+       "#endif /* _LIA_IMM_TABLE_H */");
+  return 0;
+}